@@ -14,21 +14,16 @@ This will add all ticker tables
 to replication if not done already.
 
 It assumes of course pglogical_ticker.deploy_ticker_tables()
-has been run.
+has been run.  See ticker_tables_to_add() for the tables
+this would add.
  */
-PERFORM et.set_name, pglogical.replication_set_add_table(
-  set_name:=et.set_name
-  ,relation:=('pglogical_ticker.'||quote_ident(et.tablename))::REGCLASS
+PERFORM pglogical.replication_set_add_table(
+  set_name:=t.set_name
+  ,relation:=t.relation
   --default synchronize_data is false
   ,synchronize_data:=false
 )
-FROM pglogical_ticker.eligible_tickers(p_cascade_to_set_name) et
-WHERE NOT EXISTS
-  (SELECT 1
-  FROM pglogical_ticker.rep_set_table_wrapper() rsr
-  INNER JOIN pglogical.replication_set rs ON rs.set_id = rsr.set_id
-  WHERE rsr.set_reloid = ('pglogical_ticker.'||quote_ident(et.tablename))::REGCLASS 
-    AND et.set_name = rs.set_name);
+FROM pglogical_ticker.ticker_tables_to_add(p_cascade_to_set_name) t;
 
 GET DIAGNOSTICS v_row_count = ROW_COUNT;
 RETURN v_row_count;
@@ -0,0 +1,5 @@
+CREATE OR REPLACE FUNCTION pglogical_ticker.apply_events()
+ RETURNS TABLE(database name, provider_name name, set_name name, source_time timestamp with time zone, apply_time timestamp with time zone, apply_lag interval)
+ LANGUAGE c
+AS '$libdir/pglogical_ticker', $function$pglogical_ticker_apply_events$function$
+;
@@ -0,0 +1,5 @@
+CREATE OR REPLACE FUNCTION pglogical_ticker.apply_trigger()
+ RETURNS trigger
+ LANGUAGE c
+AS '$libdir/pglogical_ticker', $function$pglogical_ticker_apply_trigger$function$
+;
@@ -2,7 +2,18 @@ CREATE OR REPLACE FUNCTION pglogical_ticker.deploy_ticker_tables(
 --For use with cascading replication, you can pass
 --a set_name in order to add all current subscription tickers 
 --to this replication set
-p_cascade_to_set_name NAME = NULL 
+p_cascade_to_set_name NAME = NULL,
+--Install the apply trigger, which logs every tick applied on
+--subscribers, see pglogical_ticker.apply_events()
+p_apply_trigger BOOLEAN = FALSE,
+--Create new tables as partitions of pglogical_ticker.ticks,
+--which needs PostgreSQL 10 or later
+p_partitioned BOOLEAN = FALSE,
+--Replicate the DDL of up to this many tables per command,
+--instead of one command per table
+p_batch_size INT = NULL,
+--Only deploy the tables of these replication sets
+p_set_names NAME[] = NULL
 )
  RETURNS integer
  LANGUAGE plpgsql
@@ -12,28 +23,124 @@ This will create the main table on both provider and
 all subscriber(s) for in use replication sets.
 
 It assumes this extension is installed both places.
+
+Every tick updates source_time of the same rows, so tables are
+created with room on each page for the new row versions, which makes
+every tick a HOT update that page pruning cleans up.  source_time must
+never be indexed for this to hold.  As pruning keeps the tables small,
+autovacuum hardly needs to visit them.  Tables which already exist get
+the same settings.
+
+Tables deployed before version 1.5 get the prev_tick_lsn column,
+which the worker fills with the commit LSN of its previous tick.
+
+With p_partitioned, tables which do not exist yet are created as
+partitions of pglogical_ticker.ticks, see migrate_to_ticks().
+
+With p_apply_trigger, the tables get a trigger which only fires for
+changes applied by pglogical, and logs the local time each tick was
+applied at.  This needs version 1.5 of the extension on subscribers.
+
+With p_batch_size, the DDL of up to that many tables, in set name order,
+is sent as one command replicated to all of their sets, so that deploying
+many sets queues few DDL messages.  A provider does not know which sets
+each of its subscribers takes, so a subscriber of any set of a batch
+creates the tables of the whole batch.  Those of sets it does not
+subscribe to stay empty, as nothing replicates or ticks them there.
+
+With p_set_names, only the tables of those replication sets are
+deployed, see provision_ticker_tables().
  */
 DECLARE
-    v_row_count INT;
+    v_row_count INT = 0;
+    v_commands INT = 0;
+    v_batch RECORD;
+    v_storage TEXT = 'fillfactor = 10,
+  autovacuum_vacuum_scale_factor = 0,
+  autovacuum_vacuum_threshold = 10000,
+  autovacuum_analyze_scale_factor = 0,
+  autovacuum_analyze_threshold = 100000';
 BEGIN
 
-PERFORM pglogical.replicate_ddl_command($$
-CREATE TABLE IF NOT EXISTS pglogical_ticker.$$||quote_ident(tablename)||$$ (
-  provider_name        NAME PRIMARY KEY,
-  source_time          TIMESTAMPTZ
-);
+IF p_batch_size < 1 THEN
+    RAISE EXCEPTION 'p_batch_size must be at least 1';
+END IF;
+
+IF p_partitioned AND to_regclass('pglogical_ticker.ticks') IS NULL THEN
+    RAISE EXCEPTION 'pglogical_ticker.ticks requires PostgreSQL 10 or later';
+END IF;
 
+FOR v_batch IN
+SELECT string_agg(d.ddl, '' ORDER BY d.rn)||$$
 SELECT pglogical_ticker.add_ext_object(
 'TABLE',
 format('%s.%s',
       'pglogical_ticker',
-      quote_ident($$||quote_literal(tablename)||$$)
+      quote_ident(t)
       )
-);
-$$, ARRAY[set_name])
-FROM pglogical_ticker.eligible_tickers(p_cascade_to_set_name);
+)
+FROM unnest($$||quote_literal(array_agg(d.tablename ORDER BY d.rn)::TEXT)||$$::NAME[]) t;
+$$ AS ddl,
+  array_agg(DISTINCT d.set_name::TEXT) AS set_names,
+  count(1) AS tables
+FROM (SELECT t.set_name,
+  t.tablename,
+  row_number() OVER (ORDER BY t.set_name, t.tablename) AS rn,
+  t.ddl
+FROM (SELECT et.set_name,
+  et.tablename,
+CASE WHEN p_partitioned THEN $$
+CREATE TABLE IF NOT EXISTS pglogical_ticker.$$||quote_ident(tablename)||$$
+PARTITION OF pglogical_ticker.ticks (
+  set_name DEFAULT $$||quote_literal(tablename)||$$,
+  PRIMARY KEY (provider_name)
+) FOR VALUES IN ($$||quote_literal(tablename)||$$)
+WITH ($$||v_storage||$$);
+$$ ELSE $$
+CREATE TABLE IF NOT EXISTS pglogical_ticker.$$||quote_ident(tablename)||$$ (
+  provider_name        NAME PRIMARY KEY,
+  source_time          TIMESTAMPTZ
+) WITH ($$||v_storage||$$);
+$$ END||$$
+ALTER TABLE pglogical_ticker.$$||quote_ident(tablename)||$$ SET ($$||v_storage||$$);
+$$||CASE WHEN NOT EXISTS
+    (SELECT 1
+    FROM pg_attribute a
+    INNER JOIN pg_class c ON c.oid = a.attrelid
+    INNER JOIN pg_namespace n ON n.oid = c.relnamespace
+    WHERE n.nspname = 'pglogical_ticker'
+      AND c.relname = tablename
+      AND a.attname = 'prev_tick_lsn'
+      AND NOT a.attisdropped)
+  --New partitions get the column from pglogical_ticker.ticks
+  AND (NOT p_partitioned OR EXISTS
+    (SELECT 1
+    FROM pg_class c
+    INNER JOIN pg_namespace n ON n.oid = c.relnamespace
+    WHERE n.nspname = 'pglogical_ticker'
+      AND c.relname = tablename)) THEN $$
+ALTER TABLE pglogical_ticker.$$||quote_ident(tablename)||$$ ADD COLUMN prev_tick_lsn PG_LSN;
+$$ ELSE '' END||CASE WHEN p_apply_trigger THEN $$
+DROP TRIGGER IF EXISTS apply_trigger ON pglogical_ticker.$$||quote_ident(tablename)||$$;
+CREATE TRIGGER apply_trigger
+BEFORE INSERT OR UPDATE ON pglogical_ticker.$$||quote_ident(tablename)||$$
+FOR EACH ROW EXECUTE PROCEDURE pglogical_ticker.apply_trigger();
+ALTER TABLE pglogical_ticker.$$||quote_ident(tablename)||$$ ENABLE REPLICA TRIGGER apply_trigger;
+$$ ELSE '' END AS ddl
+  FROM pglogical_ticker.eligible_tickers(p_cascade_to_set_name) et
+  WHERE p_set_names IS NULL OR et.set_name = ANY(p_set_names)) t) d
+GROUP BY CASE WHEN p_batch_size IS NULL THEN d.rn ELSE (d.rn - 1) / p_batch_size END
+LOOP
+    PERFORM pglogical.replicate_ddl_command(v_batch.ddl, v_batch.set_names);
+    v_commands = v_commands + 1;
+    v_row_count = v_row_count + v_batch.tables;
+END LOOP;
+
+IF p_batch_size IS NOT NULL THEN
+    RAISE NOTICE 'deployed % ticker tables in % DDL commands, saving % queue entries',
+        v_row_count, v_commands, v_row_count - v_commands;
+END IF;
 
-GET DIAGNOSTICS v_row_count = ROW_COUNT;
 RETURN v_row_count;
 
 END;
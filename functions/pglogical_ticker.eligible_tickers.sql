@@ -30,6 +30,14 @@ INNER JOIN pg_namespace n ON n.oid = c.relnamespace
 WHERE p_cascade_to_set_name IS NOT NULL 
 AND n.nspname = 'pglogical_ticker'
 AND c.relkind = 'r'
+--Only ticker tables, not other tables of the extension such as set_config
+AND EXISTS (
+    SELECT 1
+    FROM pg_attribute a
+    WHERE a.attrelid = c.oid
+      AND a.attname = 'source_time'
+      AND NOT a.attisdropped
+)
 AND EXISTS (
     SELECT 1
     FROM pglogical.replication_set rsi
@@ -0,0 +1,5 @@
+CREATE OR REPLACE FUNCTION pglogical_ticker.lag()
+ RETURNS TABLE(provider_name name, set_name name, source_time timestamp with time zone, lag interval, staleness interval)
+ LANGUAGE c
+AS '$libdir/pglogical_ticker', $function$pglogical_ticker_lag$function$
+;
@@ -0,0 +1,5 @@
+CREATE OR REPLACE FUNCTION pglogical_ticker.lag_histogram()
+ RETURNS TABLE(database name, provider_name name, set_name name, since timestamp with time zone, samples bigint, p50_ms double precision, p90_ms double precision, p99_ms double precision, max_ms double precision)
+ LANGUAGE c
+AS '$libdir/pglogical_ticker', $function$pglogical_ticker_lag_histogram$function$
+;
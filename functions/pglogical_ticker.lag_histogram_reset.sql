@@ -0,0 +1,5 @@
+CREATE OR REPLACE FUNCTION pglogical_ticker.lag_histogram_reset(p_set_name name = NULL)
+ RETURNS void
+ LANGUAGE c
+AS '$libdir/pglogical_ticker', $function$pglogical_ticker_lag_histogram_reset$function$
+;
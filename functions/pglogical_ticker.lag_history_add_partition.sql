@@ -0,0 +1,34 @@
+CREATE OR REPLACE FUNCTION pglogical_ticker.lag_history_add_partition(
+p_table NAME,
+--day, month or year
+p_unit TEXT,
+p_time TIMESTAMPTZ
+)
+ RETURNS void
+ LANGUAGE plpgsql
+AS $function$
+/****
+Create the partition of a lag history table that covers p_time.
+Partitions are bounded on UTC days, months or years, whatever the
+time zone of the session, and are named after their start.
+ */
+DECLARE
+    v_start TIMESTAMP = date_trunc(p_unit, p_time AT TIME ZONE 'UTC');
+    v_end TIMESTAMP = v_start + ('1 '||p_unit)::INTERVAL;
+BEGIN
+
+EXECUTE format('CREATE TABLE IF NOT EXISTS pglogical_ticker.%I
+PARTITION OF pglogical_ticker.%I
+FOR VALUES FROM (%L) TO (%L)',
+    p_table||'_p'||to_char(v_start, CASE p_unit
+                                         WHEN 'day' THEN 'YYYYMMDD'
+                                         WHEN 'month' THEN 'YYYYMM'
+                                         ELSE 'YYYY'
+                                     END),
+    p_table,
+    to_char(v_start, 'YYYY-MM-DD HH24:MI:SS')||'+00',
+    to_char(v_end, 'YYYY-MM-DD HH24:MI:SS')||'+00');
+
+END;
+$function$
+;
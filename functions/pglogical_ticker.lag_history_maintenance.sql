@@ -0,0 +1,94 @@
+CREATE OR REPLACE FUNCTION pglogical_ticker.lag_history_maintenance(
+--Default to pglogical_ticker.lag_history_retention_days
+p_raw_retention INTERVAL = NULL,
+--Default to pglogical_ticker.lag_history_rollup_retention_days
+p_rollup_retention INTERVAL = NULL
+)
+ RETURNS void
+ LANGUAGE plpgsql
+AS $function$
+/****
+This is run every hour by the worker when pglogical_ticker.lag_history
+is on.  It:
+- creates the partitions needed until tomorrow
+- rolls the raw samples of complete minutes up into lag_history_1m, and
+  those of complete hours up into lag_history_1h
+- drops the partitions of raw samples and of 1 minute aggregates which
+  are past their retention.  Hourly aggregates are kept.
+
+Expired data is only ever dropped a partition at a time, so history
+costs no DELETE and no vacuum.
+ */
+DECLARE
+    v_now TIMESTAMPTZ = now();
+    v_from TIMESTAMPTZ;
+    v_until TIMESTAMPTZ;
+    v_end TIMESTAMPTZ;
+    v_part RECORD;
+BEGIN
+
+IF to_regclass('pglogical_ticker.lag_history') IS NULL THEN
+    RAISE EXCEPTION 'lag history requires PostgreSQL 10 or later';
+END IF;
+
+p_raw_retention = COALESCE(p_raw_retention,
+    make_interval(days := COALESCE(NULLIF(current_setting('pglogical_ticker.lag_history_retention_days', true), ''), '7')::INT));
+p_rollup_retention = COALESCE(p_rollup_retention,
+    make_interval(days := COALESCE(NULLIF(current_setting('pglogical_ticker.lag_history_rollup_retention_days', true), ''), '90')::INT));
+
+PERFORM pglogical_ticker.lag_history_add_partition('lag_history', 'day', v_now);
+PERFORM pglogical_ticker.lag_history_add_partition('lag_history', 'day', v_now + INTERVAL '1 day');
+PERFORM pglogical_ticker.lag_history_add_partition('lag_history_1m', 'month', v_now);
+PERFORM pglogical_ticker.lag_history_add_partition('lag_history_1m', 'month', v_now + INTERVAL '1 day');
+PERFORM pglogical_ticker.lag_history_add_partition('lag_history_1h', 'year', v_now);
+PERFORM pglogical_ticker.lag_history_add_partition('lag_history_1h', 'year', v_now + INTERVAL '1 day');
+
+--Samples are written in batches, so leave a minute for the last ones to arrive
+SELECT max(bucket) + INTERVAL '1 minute' INTO v_from FROM pglogical_ticker.lag_history_1m;
+v_until = date_trunc('minute', (v_now - INTERVAL '1 minute') AT TIME ZONE 'UTC') AT TIME ZONE 'UTC';
+
+INSERT INTO pglogical_ticker.lag_history_1m
+    (bucket, provider_name, set_name, samples, avg_lag, max_lag)
+SELECT date_trunc('minute', sample_time AT TIME ZONE 'UTC') AT TIME ZONE 'UTC',
+    provider_name, set_name, count(1), avg(lag), max(lag)
+FROM pglogical_ticker.lag_history
+WHERE sample_time >= COALESCE(v_from, '-infinity')
+  AND sample_time < v_until
+GROUP BY 1, 2, 3;
+
+SELECT max(bucket) + INTERVAL '1 hour' INTO v_from FROM pglogical_ticker.lag_history_1h;
+v_until = date_trunc('hour', v_until AT TIME ZONE 'UTC') AT TIME ZONE 'UTC';
+
+INSERT INTO pglogical_ticker.lag_history_1h
+    (bucket, provider_name, set_name, samples, avg_lag, max_lag)
+SELECT date_trunc('hour', bucket AT TIME ZONE 'UTC') AT TIME ZONE 'UTC',
+    provider_name, set_name, sum(samples),
+    sum(avg_lag * samples::FLOAT8) / sum(samples)::FLOAT8, max(max_lag)
+FROM pglogical_ticker.lag_history_1m
+WHERE bucket >= COALESCE(v_from, '-infinity')
+  AND bucket < v_until
+GROUP BY 1, 2, 3;
+
+FOR v_part IN
+    SELECT c.relname, p.relname AS parent
+    FROM pg_inherits i
+    INNER JOIN pg_class c ON c.oid = i.inhrelid
+    INNER JOIN pg_class p ON p.oid = i.inhparent
+    INNER JOIN pg_namespace n ON n.oid = p.relnamespace
+    WHERE n.nspname = 'pglogical_ticker'
+      AND p.relname IN ('lag_history', 'lag_history_1m')
+LOOP
+    IF v_part.parent = 'lag_history' THEN
+        v_end = (to_date(right(v_part.relname, 8), 'YYYYMMDD') + INTERVAL '1 day') AT TIME ZONE 'UTC';
+        CONTINUE WHEN v_end > v_now - p_raw_retention;
+    ELSE
+        v_end = (to_date(right(v_part.relname, 6), 'YYYYMM') + INTERVAL '1 month') AT TIME ZONE 'UTC';
+        CONTINUE WHEN v_end > v_now - p_rollup_retention;
+    END IF;
+
+    EXECUTE format('DROP TABLE pglogical_ticker.%I', v_part.relname);
+END LOOP;
+
+END;
+$function$
+;
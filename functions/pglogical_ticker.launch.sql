@@ -12,6 +12,7 @@ AND NOT EXISTS
     (SELECT 1
     FROM pg_stat_activity psa
     WHERE NOT pid = pg_backend_pid()
+      AND psa.datname = current_database()
       AND application_name LIKE 'pglogical_ticker%')
 AND NOT pg_is_in_recovery();
 $function$
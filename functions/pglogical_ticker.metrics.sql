@@ -0,0 +1,5 @@
+CREATE OR REPLACE FUNCTION pglogical_ticker.metrics()
+ RETURNS text
+ LANGUAGE c
+AS '$libdir/pglogical_ticker', $function$pglogical_ticker_metrics$function$
+;
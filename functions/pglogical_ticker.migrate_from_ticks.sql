@@ -0,0 +1,37 @@
+CREATE OR REPLACE FUNCTION pglogical_ticker.migrate_from_ticks()
+ RETURNS integer
+ LANGUAGE plpgsql
+AS $function$
+/****
+Detach every partition of pglogical_ticker.ticks which is in replication
+back into a ticker table of its own, on the provider and, through
+pglogical.replicate_ddl_command, on subscribers.  This reverses
+migrate_to_ticks(), and works as well for partitions created by
+deploy_ticker_tables(p_partitioned := true).
+ */
+DECLARE
+    v_row_count INT;
+BEGIN
+
+IF to_regclass('pglogical_ticker.ticks') IS NULL THEN
+    RAISE EXCEPTION 'pglogical_ticker.ticks requires PostgreSQL 10 or later';
+END IF;
+
+PERFORM pglogical.replicate_ddl_command($$
+ALTER TABLE pglogical_ticker.ticks DETACH PARTITION pglogical_ticker.$$||quote_ident(t.relname)||$$;
+ALTER TABLE pglogical_ticker.$$||quote_ident(t.relname)||$$ DROP COLUMN set_name;
+$$, t.set_names)
+FROM (SELECT c.relname, array_agg(rs.set_name::TEXT ORDER BY rs.set_name) AS set_names
+    FROM pg_inherits i
+    INNER JOIN pg_class c ON c.oid = i.inhrelid
+    INNER JOIN pglogical_ticker.rep_set_table_wrapper() rst ON rst.set_reloid = c.oid
+    INNER JOIN pglogical.replication_set rs ON rs.set_id = rst.set_id
+    WHERE i.inhparent = 'pglogical_ticker.ticks'::REGCLASS
+    GROUP BY c.relname) t;
+
+GET DIAGNOSTICS v_row_count = ROW_COUNT;
+RETURN v_row_count;
+
+END;
+$function$
+;
@@ -0,0 +1,49 @@
+CREATE OR REPLACE FUNCTION pglogical_ticker.migrate_to_ticks()
+ RETURNS integer
+ LANGUAGE plpgsql
+AS $function$
+/****
+Attach every ticker table in replication as a partition of
+pglogical_ticker.ticks, on the provider and, through
+pglogical.replicate_ddl_command, on subscribers.
+
+Tables are attached in place: they keep their name, their replication
+sets and their rows, and only get a set_name column which defaults to the
+table name.  migrate_from_ticks() reverses this.
+ */
+DECLARE
+    v_row_count INT;
+BEGIN
+
+IF to_regclass('pglogical_ticker.ticks') IS NULL THEN
+    RAISE EXCEPTION 'pglogical_ticker.ticks requires PostgreSQL 10 or later';
+END IF;
+
+PERFORM pglogical.replicate_ddl_command($$
+ALTER TABLE pglogical_ticker.$$||quote_ident(t.relname)||$$ ADD COLUMN IF NOT EXISTS prev_tick_lsn PG_LSN;
+ALTER TABLE pglogical_ticker.$$||quote_ident(t.relname)||$$ ADD COLUMN set_name NAME NOT NULL DEFAULT $$||quote_literal(t.relname)||$$;
+ALTER TABLE pglogical_ticker.ticks ATTACH PARTITION pglogical_ticker.$$||quote_ident(t.relname)||$$ FOR VALUES IN ($$||quote_literal(t.relname)||$$);
+$$, t.set_names)
+FROM (SELECT c.relname, array_agg(rs.set_name::TEXT ORDER BY rs.set_name) AS set_names
+    FROM pg_class c
+    INNER JOIN pg_namespace n ON n.oid = c.relnamespace
+    INNER JOIN pglogical_ticker.rep_set_table_wrapper() rst ON rst.set_reloid = c.oid
+    INNER JOIN pglogical.replication_set rs ON rs.set_id = rst.set_id
+    WHERE n.nspname = 'pglogical_ticker'
+      AND c.relkind = 'r'
+      AND NOT c.relispartition
+      AND EXISTS (
+        SELECT 1
+        FROM pg_attribute a
+        WHERE a.attrelid = c.oid
+          AND a.attname = 'source_time'
+          AND NOT a.attisdropped
+      )
+    GROUP BY c.relname) t;
+
+GET DIAGNOSTICS v_row_count = ROW_COUNT;
+RETURN v_row_count;
+
+END;
+$function$
+;
@@ -0,0 +1,51 @@
+CREATE OR REPLACE FUNCTION pglogical_ticker.provision_ticker_tables(p_set_names NAME[])
+ RETURNS integer
+ LANGUAGE plpgsql
+AS $function$
+/****
+Deploy the ticker tables of the given replication sets which have none
+yet, and add them to their set, as deploy_ticker_tables() and
+add_ticker_tables_to_replication() do for all sets.  The worker calls
+this for new replication sets with pglogical_ticker.auto_provision.
+
+Sets which already have a ticker table are left alone, so no DDL is
+queued for them.  A set that cannot be provisioned only gets a warning,
+so that it does not keep the others from being provisioned; the worker
+tries it again later.
+ */
+DECLARE
+    v_set_name NAME;
+    v_row_count INT = 0;
+BEGIN
+
+FOR v_set_name IN
+    SELECT rs.set_name
+    FROM pglogical.replication_set rs
+    WHERE rs.set_name = ANY(p_set_names)
+      AND NOT EXISTS
+        (SELECT 1
+        FROM pg_class c
+        INNER JOIN pg_namespace n ON n.oid = c.relnamespace
+        WHERE n.nspname = 'pglogical_ticker'
+          AND c.relname = rs.set_name)
+    ORDER BY rs.set_name
+LOOP
+    BEGIN
+        PERFORM pglogical_ticker.deploy_ticker_tables(p_set_names := ARRAY[v_set_name]);
+        PERFORM pglogical.replication_set_add_table(
+          set_name:=v_set_name
+          ,relation:=('pglogical_ticker.'||quote_ident(v_set_name))::REGCLASS
+          ,synchronize_data:=false
+        );
+        v_row_count = v_row_count + 1;
+    EXCEPTION WHEN OTHERS THEN
+        RAISE WARNING 'pglogical_ticker: could not provision ticker table of replication set "%": %',
+            v_set_name, SQLERRM;
+    END;
+END LOOP;
+
+RETURN v_row_count;
+
+END;
+$function$
+;
@@ -0,0 +1,5 @@
+CREATE OR REPLACE FUNCTION pglogical_ticker.set_config_changed()
+ RETURNS trigger
+ LANGUAGE c
+AS '$libdir/pglogical_ticker', $function$pglogical_ticker_set_config_changed$function$
+;
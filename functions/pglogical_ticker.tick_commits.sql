@@ -0,0 +1,5 @@
+CREATE OR REPLACE FUNCTION pglogical_ticker.tick_commits()
+ RETURNS TABLE(database name, tick_time timestamp with time zone, commit_lsn pg_lsn)
+ LANGUAGE c
+AS '$libdir/pglogical_ticker', $function$pglogical_ticker_tick_commits$function$
+;
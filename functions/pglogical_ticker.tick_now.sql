@@ -0,0 +1,6 @@
+CREATE OR REPLACE FUNCTION pglogical_ticker.tick_now(set_names name[])
+ RETURNS TABLE(source_time timestamp with time zone, commit_time timestamp with time zone, commit_lsn pg_lsn)
+ LANGUAGE c
+ STRICT
+AS '$libdir/pglogical_ticker', $function$pglogical_ticker_tick_now$function$
+;
@@ -0,0 +1,5 @@
+CREATE OR REPLACE FUNCTION pglogical_ticker.tick_phase_stats()
+ RETURNS TABLE(database name, phase text, calls bigint, total_ms double precision, avg_ms double precision, recent_avg_ms double precision, max_ms double precision, last_ms double precision)
+ LANGUAGE c
+AS '$libdir/pglogical_ticker', $function$pglogical_ticker_tick_phase_stats$function$
+;
@@ -0,0 +1,30 @@
+CREATE OR REPLACE FUNCTION pglogical_ticker.ticker_table_stats()
+ RETURNS TABLE(tablename name, updates bigint, hot_updates bigint, hot_ratio numeric, dead_tuples bigint, pages bigint, last_autovacuum timestamp with time zone)
+ LANGUAGE sql
+ STABLE
+AS $function$
+/****
+Bloat telemetry of the ticker tables.  With the layout created by
+deploy_ticker_tables(), hot_ratio should stay at 1 and pages at 1.
+ */
+SELECT c.relname,
+  pg_stat_get_tuples_updated(c.oid),
+  pg_stat_get_tuples_hot_updated(c.oid),
+  round(pg_stat_get_tuples_hot_updated(c.oid)::NUMERIC
+    / NULLIF(pg_stat_get_tuples_updated(c.oid), 0), 4),
+  pg_stat_get_dead_tuples(c.oid),
+  pg_relation_size(c.oid) / current_setting('block_size')::BIGINT,
+  pg_stat_get_last_autovacuum_time(c.oid)
+FROM pg_class c
+INNER JOIN pg_namespace n ON n.oid = c.relnamespace
+WHERE n.nspname = 'pglogical_ticker'
+  AND c.relkind = 'r'
+  AND EXISTS (
+    SELECT 1
+    FROM pg_attribute a
+    WHERE a.attrelid = c.oid
+      AND a.attname = 'source_time'
+      AND NOT a.attisdropped)
+ORDER BY c.relname;
+$function$
+;
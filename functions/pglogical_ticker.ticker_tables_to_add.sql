@@ -0,0 +1,35 @@
+CREATE OR REPLACE FUNCTION pglogical_ticker.ticker_tables_to_add(
+--Same as for add_ticker_tables_to_replication()
+p_cascade_to_set_name NAME = NULL
+)
+ RETURNS TABLE (set_name name, relation regclass)
+ LANGUAGE sql
+ STABLE
+AS $function$
+/****
+The ticker tables add_ticker_tables_to_replication() would add to
+replication, which makes for a dry run of it.
+
+Membership of the replication sets is read once, and the eligible
+tickers are anti-joined to it, instead of reading it again for
+every ticker.
+ */
+WITH membership AS (
+  SELECT rs.set_name, rsr.set_reloid
+  FROM pglogical_ticker.rep_set_table_wrapper() rsr
+  INNER JOIN pglogical.replication_set rs ON rs.set_id = rsr.set_id
+)
+, eligible AS (
+  SELECT et.set_name, ('pglogical_ticker.'||quote_ident(et.tablename))::REGCLASS AS relation
+  FROM pglogical_ticker.eligible_tickers(p_cascade_to_set_name) et
+)
+SELECT e.set_name, e.relation
+FROM eligible e
+WHERE NOT EXISTS
+  (SELECT 1
+  FROM membership m
+  WHERE m.set_reloid = e.relation
+    AND m.set_name = e.set_name)
+ORDER BY e.set_name, e.relation::TEXT;
+$function$
+;
@@ -0,0 +1,5 @@
+CREATE OR REPLACE FUNCTION pglogical_ticker.worker_stats()
+ RETURNS TABLE(database name, worker_pid integer, interval_ms double precision, ticks bigint, late_ticks bigint, missed_ticks bigint)
+ LANGUAGE c
+AS '$libdir/pglogical_ticker', $function$pglogical_ticker_worker_stats$function$
+;
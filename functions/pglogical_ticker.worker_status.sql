@@ -0,0 +1,5 @@
+CREATE OR REPLACE FUNCTION pglogical_ticker.worker_status()
+ RETURNS TABLE(database name, set_name name, worker_pid integer, last_tick_time timestamp with time zone, last_tick_duration_ms double precision, last_commit_lsn pg_lsn, consecutive_errors bigint, tick_interval_ms double precision)
+ LANGUAGE c
+AS '$libdir/pglogical_ticker', $function$pglogical_ticker_worker_status$function$
+;
@@ -0,0 +1,1498 @@
+/* pglogical_ticker--1.0.sql */
+
+-- complain if script is sourced in psql, rather than via CREATE EXTENSION
+\echo Use "CREATE EXTENSION pglogical_ticker" to load this file. \quit
+
+CREATE FUNCTION pglogical_ticker._launch(oid)
+  RETURNS pg_catalog.INT4 STRICT
+AS 'MODULE_PATHNAME', 'pglogical_ticker_launch'
+LANGUAGE C;
+
+CREATE FUNCTION pglogical_ticker.launch()
+  RETURNS pg_catalog.INT4 STRICT
+AS $BODY$
+SELECT pglogical_ticker._launch(oid)
+FROM pg_database
+WHERE datname = current_database()
+--This should be improved in the future but should do 
+--the job for now.
+AND NOT EXISTS
+    (SELECT 1
+    FROM pg_stat_activity psa
+    WHERE NOT pid = pg_backend_pid()
+      AND query = 'SELECT pglogical_ticker.tick();');
+$BODY$
+LANGUAGE SQL;
+
+CREATE FUNCTION pglogical_ticker.dependency_update()
+RETURNS VOID AS
+$DEPS$
+/*****
+This handles the rename of pglogical.replication_set_relation to pglogical_ticker.rep_set_table_wrapper from version 1 to 2
+ */
+BEGIN
+
+IF EXISTS (SELECT 1 FROM information_schema.tables WHERE table_name = 'rep_set_table_wrapper' AND table_schema = 'pglogical_ticker') THEN
+    PERFORM pglogical_ticker.drop_ext_object('VIEW','pglogical_ticker.rep_set_table_wrapper');
+    DROP VIEW pglogical_ticker.rep_set_table_wrapper;
+END IF;
+IF (SELECT extversion FROM pg_extension WHERE extname = 'pglogical') ~* '^1.*' THEN
+
+    CREATE VIEW pglogical_ticker.rep_set_table_wrapper AS
+    SELECT *
+    FROM pglogical.replication_set_relation;
+
+ELSE
+
+    CREATE VIEW pglogical_ticker.rep_set_table_wrapper AS
+    SELECT *
+    FROM pglogical.replication_set_table;
+
+END IF;
+
+END;
+$DEPS$
+LANGUAGE plpgsql;
+
+SELECT pglogical_ticker.dependency_update();
+
+CREATE OR REPLACE FUNCTION pglogical_ticker.add_ext_object
+  (p_type text
+  , p_full_obj_name text)
+RETURNS VOID AS
+$BODY$
+BEGIN
+PERFORM pglogical_ticker.toggle_ext_object(p_type, p_full_obj_name, 'ADD');
+END;
+$BODY$
+LANGUAGE plpgsql;
+
+CREATE OR REPLACE FUNCTION pglogical_ticker.drop_ext_object
+  (p_type text
+  , p_full_obj_name text)
+RETURNS VOID AS
+$BODY$
+BEGIN
+PERFORM pglogical_ticker.toggle_ext_object(p_type, p_full_obj_name, 'DROP');
+END;
+$BODY$
+LANGUAGE plpgsql;
+
+CREATE OR REPLACE FUNCTION pglogical_ticker.toggle_ext_object
+  (p_type text
+  , p_full_obj_name text
+  , p_toggle text)
+RETURNS VOID AS
+$BODY$
+DECLARE
+  c_valid_types TEXT[] = ARRAY['EVENT TRIGGER','FUNCTION','VIEW','TABLE'];
+  c_valid_toggles TEXT[] = ARRAY['ADD','DROP'];
+BEGIN
+
+IF NOT (SELECT ARRAY[upper(p_type)] && c_valid_types) THEN
+  RAISE EXCEPTION 'Must pass one of % as 1st arg.', array_to_string(c_valid_types,',');
+END IF;
+
+IF NOT (SELECT ARRAY[upper(p_toggle)] && c_valid_toggles) THEN
+  RAISE EXCEPTION 'Must pass one of % as 3rd arg.', array_to_string(c_valid_toggles,',');
+END IF;
+
+EXECUTE 'ALTER EXTENSION pglogical_ticker '||p_toggle||' '||p_type||' '||p_full_obj_name;
+
+/*EXCEPTION
+  WHEN undefined_function THEN
+    RETURN;
+  WHEN undefined_object THEN
+    RETURN;
+  WHEN object_not_in_prerequisite_state THEN
+    RETURN;
+*/
+END;
+$BODY$
+LANGUAGE plpgsql;
+
+CREATE FUNCTION pglogical_ticker.deploy_ticker_tables()
+RETURNS INT AS
+$BODY$
+/****
+This will create the main table on both provider and
+all subscriber(s) for in use replication sets.
+
+It assumes this extension is installed both places.
+ */
+DECLARE
+    v_row_count INT;
+BEGIN
+
+PERFORM pglogical.replicate_ddl_command($$
+CREATE TABLE IF NOT EXISTS pglogical_ticker.$$||quote_ident(set_name)||$$ (
+  provider_name        NAME PRIMARY KEY,
+  source_time          TIMESTAMPTZ
+);$$, ARRAY[set_name])
+FROM pglogical.replication_set;
+
+PERFORM pglogical_ticker.add_ext_object('TABLE', 'pglogical_ticker.'||quote_ident(set_name))
+FROM pglogical.replication_set;
+
+GET DIAGNOSTICS v_row_count = ROW_COUNT;
+RETURN v_row_count;
+
+END;
+$BODY$
+LANGUAGE plpgsql;
+
+CREATE FUNCTION pglogical_ticker.all_repset_tickers()
+RETURNS TABLE (provider_name NAME, set_name NAME, source_time TIMESTAMPTZ)
+AS
+$BODY$
+DECLARE v_sql TEXT;
+BEGIN
+
+SELECT COALESCE(
+        string_agg(
+            format(
+                'SELECT provider_name, %s::NAME AS set_name, source_time FROM %s',
+                quote_literal(rs.set_name),
+                relid::REGCLASS::TEXT
+                ),
+            E'\nUNION ALL\n'
+            ),
+        'SELECT NULL::NAME, NULL::NAME, NULL::TIMESTAMPTZ') INTO v_sql
+FROM pg_stat_user_tables st
+INNER JOIN pglogical.replication_set rs ON rs.set_name = st.relname
+WHERE schemaname = 'pglogical_ticker'; 
+
+RETURN QUERY EXECUTE v_sql;
+
+END;
+$BODY$
+LANGUAGE plpgsql;
+
+CREATE FUNCTION pglogical_ticker.all_subscription_tickers()
+RETURNS TABLE (provider_name NAME, set_name NAME, source_time TIMESTAMPTZ)
+AS
+$BODY$
+DECLARE v_sql TEXT;
+BEGIN
+
+WITH sub_rep_sets AS (
+SELECT DISTINCT unnest(sub_replication_sets) AS set_name
+FROM pglogical.subscription
+)
+
+SELECT COALESCE(
+        string_agg(
+            format(
+                'SELECT provider_name, %s::NAME AS set_name, source_time FROM %s',
+                quote_literal(srs.set_name),
+                relid::REGCLASS::TEXT
+                ),
+            E'\nUNION ALL\n'
+            ),
+        'SELECT NULL::NAME, NULL::NAME, NULL::TIMESTAMPTZ') INTO v_sql
+FROM pg_stat_user_tables st
+INNER JOIN sub_rep_sets srs ON srs.set_name = st.relname
+WHERE schemaname = 'pglogical_ticker'; 
+
+RETURN QUERY EXECUTE v_sql;
+
+END;
+$BODY$
+LANGUAGE plpgsql;
+
+CREATE FUNCTION pglogical_ticker.add_ticker_tables_to_replication()
+RETURNS INT AS
+$BODY$
+DECLARE v_row_count INT;
+BEGIN
+/****
+This will add all ticker tables
+to replication if not done already.
+
+It assumes of course pglogical_ticker.deploy_ticker_tables()
+has been run.
+ */
+PERFORM rs.set_name, pglogical.replication_set_add_table(
+  set_name:=rs.set_name
+  ,relation:=('pglogical_ticker.'||quote_ident(set_name))::REGCLASS
+  --default synchronize_data is false
+  ,synchronize_data:=false
+)
+FROM pglogical.replication_set rs 
+WHERE NOT EXISTS
+  (SELECT 1
+  FROM pglogical_ticker.rep_set_table_wrapper rsr
+  WHERE rsr.set_reloid = ('pglogical_ticker.'||quote_ident(set_name))::REGCLASS 
+    AND rsr.set_id = rs.set_id);
+
+GET DIAGNOSTICS v_row_count = ROW_COUNT;
+RETURN v_row_count;
+
+END;
+$BODY$
+LANGUAGE plpgsql;
+
+CREATE FUNCTION pglogical_ticker.tick_rep_set(p_set_name name)
+RETURNS INT AS
+$BODY$
+DECLARE
+    v_sql TEXT;
+BEGIN
+
+v_sql:=$$
+INSERT INTO pglogical_ticker.$$||quote_ident(p_set_name)||$$ (provider_name, source_time)
+SELECT ni.if_name, now() AS source_time
+FROM pglogical.replication_set rs
+INNER JOIN pglogical.node n ON n.node_id = rs.set_nodeid
+INNER JOIN pglogical.node_interface ni ON ni.if_nodeid = n.node_id
+WHERE EXISTS (SELECT 1
+  FROM pglogical_ticker.rep_set_table_wrapper rsr
+  WHERE rsr.set_id = rs.set_id)
+ON CONFLICT (provider_name, replication_set_name)
+DO UPDATE
+SET source_time = now();
+$$;
+
+EXECUTE v_sql;
+
+END;
+$BODY$
+LANGUAGE plpgsql;
+
+CREATE FUNCTION pglogical_ticker.tick()
+RETURNS VOID AS
+$BODY$
+DECLARE 
+    v_record RECORD;
+    v_sql TEXT;
+    v_row_count INT;
+BEGIN
+
+FOR v_record IN SELECT set_name FROM pglogical.replication_set ORDER BY set_name
+LOOP
+
+    v_sql:=$$
+    INSERT INTO pglogical_ticker.$$||quote_ident(v_record.set_name)||$$ (provider_name, source_time)
+    SELECT ni.if_name, now() AS source_time
+    FROM pglogical.replication_set rs
+    INNER JOIN pglogical.node n ON n.node_id = rs.set_nodeid
+    INNER JOIN pglogical.node_interface ni ON ni.if_nodeid = n.node_id
+    WHERE rs.set_name = '$$||quote_ident(v_record.set_name)||$$'
+    ON CONFLICT (provider_name)
+    DO UPDATE
+    SET source_time = now();
+    $$;
+
+    EXECUTE v_sql;
+
+END LOOP;
+
+END;
+$BODY$
+LANGUAGE plpgsql;
+
+REVOKE EXECUTE ON ALL FUNCTIONS IN SCHEMA pglogical_ticker FROM PUBLIC;
+/* pglogical_ticker--1.0--1.1.sql */
+
+-- complain if script is sourced in psql, rather than via CREATE EXTENSION
+\echo Use "CREATE EXTENSION pglogical_ticker" to load this file. \quit
+
+--This must be done AFTER we update the function def
+SELECT pglogical_ticker.drop_ext_object('FUNCTION','pglogical_ticker.dependency_update()');
+DROP FUNCTION pglogical_ticker.dependency_update();
+SELECT pglogical_ticker.drop_ext_object('VIEW','pglogical_ticker.rep_set_table_wrapper');
+DROP VIEW IF EXISTS pglogical_ticker.rep_set_table_wrapper; 
+
+
+CREATE OR REPLACE FUNCTION pglogical_ticker.toggle_ext_object(p_type text, p_full_obj_name text, p_toggle text)
+ RETURNS void
+ LANGUAGE plpgsql
+AS $function$
+DECLARE
+  c_valid_types TEXT[] = ARRAY['EVENT TRIGGER','FUNCTION','VIEW','TABLE'];
+  c_valid_toggles TEXT[] = ARRAY['ADD','DROP'];
+BEGIN
+
+IF NOT (SELECT ARRAY[upper(p_type)] && c_valid_types) THEN
+  RAISE EXCEPTION 'Must pass one of % as 1st arg.', array_to_string(c_valid_types,',');
+END IF;
+
+IF NOT (SELECT ARRAY[upper(p_toggle)] && c_valid_toggles) THEN
+  RAISE EXCEPTION 'Must pass one of % as 3rd arg.', array_to_string(c_valid_toggles,',');
+END IF;
+
+EXECUTE 'ALTER EXTENSION pglogical_ticker '||p_toggle||' '||p_type||' '||p_full_obj_name;
+
+EXCEPTION
+  WHEN undefined_function THEN
+    RETURN;
+  WHEN undefined_object THEN
+    RETURN;
+  WHEN object_not_in_prerequisite_state THEN
+    RETURN;
+
+END;
+$function$
+;
+
+
+CREATE OR REPLACE FUNCTION pglogical_ticker.rep_set_table_wrapper()
+ RETURNS TABLE (set_id OID, set_reloid REGCLASS)
+ LANGUAGE plpgsql
+AS $function$
+/*****
+This handles the rename of pglogical.replication_set_relation to pglogical_ticker.rep_set_table_wrapper from version 1 to 2
+ */
+BEGIN
+
+IF EXISTS (SELECT 1 FROM pg_tables WHERE schemaname = 'pglogical' AND tablename = 'replication_set_table') THEN
+    RETURN QUERY
+    SELECT r.set_id, r.set_reloid 
+    FROM pglogical.replication_set_table r;
+
+ELSEIF EXISTS (SELECT 1 FROM pg_tables WHERE schemaname = 'pglogical' AND tablename = 'replication_set_relation') THEN
+    RETURN QUERY
+    SELECT r.set_id, r.set_reloid 
+    FROM pglogical.replication_set_relation r;
+
+ELSE
+    RAISE EXCEPTION 'No table pglogical.replication_set_relation or pglogical.replication_set_table found';
+END IF;
+
+END;
+$function$
+;
+
+
+CREATE OR REPLACE FUNCTION pglogical_ticker.add_ticker_tables_to_replication()
+ RETURNS integer
+ LANGUAGE plpgsql
+AS $function$
+DECLARE v_row_count INT;
+BEGIN
+/****
+This will add all ticker tables
+to replication if not done already.
+
+It assumes of course pglogical_ticker.deploy_ticker_tables()
+has been run.
+ */
+PERFORM rs.set_name, pglogical.replication_set_add_table(
+  set_name:=rs.set_name
+  ,relation:=('pglogical_ticker.'||quote_ident(set_name))::REGCLASS
+  --default synchronize_data is false
+  ,synchronize_data:=false
+)
+FROM pglogical.replication_set rs 
+WHERE NOT EXISTS
+  (SELECT 1
+  FROM pglogical_ticker.rep_set_table_wrapper() rsr
+  WHERE rsr.set_reloid = ('pglogical_ticker.'||quote_ident(set_name))::REGCLASS 
+    AND rsr.set_id = rs.set_id);
+
+GET DIAGNOSTICS v_row_count = ROW_COUNT;
+RETURN v_row_count;
+
+END;
+$function$
+;
+
+
+CREATE OR REPLACE FUNCTION pglogical_ticker.tick_rep_set(p_set_name name)
+ RETURNS integer
+ LANGUAGE plpgsql
+AS $function$
+DECLARE
+    v_sql TEXT;
+BEGIN
+
+v_sql:=$$
+INSERT INTO pglogical_ticker.$$||quote_ident(p_set_name)||$$ (provider_name, source_time)
+SELECT ni.if_name, now() AS source_time
+FROM pglogical.replication_set rs
+INNER JOIN pglogical.node n ON n.node_id = rs.set_nodeid
+INNER JOIN pglogical.node_interface ni ON ni.if_nodeid = n.node_id
+WHERE EXISTS (SELECT 1
+  FROM pglogical_ticker.rep_set_table_wrapper() rsr
+  WHERE rsr.set_id = rs.set_id)
+ON CONFLICT (provider_name, replication_set_name)
+DO UPDATE
+SET source_time = now();
+$$;
+
+EXECUTE v_sql;
+
+END;
+$function$
+;
+
+
+CREATE OR REPLACE FUNCTION pglogical_ticker.launch()
+ RETURNS integer
+ LANGUAGE sql
+ STRICT
+AS $function$
+SELECT pglogical_ticker._launch(oid)
+FROM pg_database
+WHERE datname = current_database()
+--This should be improved in the future but should do 
+--the job for now.
+AND NOT EXISTS
+    (SELECT 1
+    FROM pg_stat_activity psa
+    WHERE NOT pid = pg_backend_pid()
+      AND query = 'SELECT pglogical_ticker.tick();')
+AND NOT pg_is_in_recovery();
+$function$
+;
+
+CREATE OR REPLACE FUNCTION pglogical_ticker.launch_if_repset_tables()
+ RETURNS integer
+ LANGUAGE sql
+AS $function$
+SELECT pglogical_ticker.launch()
+WHERE EXISTS (SELECT 1 FROM pglogical_ticker.rep_set_table_wrapper());
+$function$
+;
+
+/* pglogical_ticker--1.1--1.2.sql */
+
+-- complain if script is sourced in psql, rather than via CREATE EXTENSION
+\echo Use "CREATE EXTENSION pglogical_ticker" to load this file. \quit
+
+DROP FUNCTION pglogical_ticker.deploy_ticker_tables(); 
+DROP FUNCTION pglogical_ticker.add_ticker_tables_to_replication();
+CREATE OR REPLACE FUNCTION pglogical_ticker.eligible_tickers
+(
+/***
+"Eligible tickers" are defined as replication sets and tables
+that are eligible to be created or added to replication, either
+because the replication sets exist, or with cascading replication,
+the tables already exist to add to a specified replication set 
+p_cascade_to_set_name as cascaded tickers.
+***/
+p_cascade_to_set_name NAME = NULL 
+)
+ RETURNS TABLE (set_name name, tablename name) 
+ LANGUAGE plpgsql
+AS $function$
+/****
+It assumes this extension is installed both places!
+ */
+BEGIN
+
+RETURN QUERY
+--In the generic case, always tablename = set_name 
+SELECT rs.set_name, rs.set_name AS tablename
+FROM pglogical.replication_set rs
+WHERE p_cascade_to_set_name IS NULL
+UNION
+--For cascading replication, we override set_name
+SELECT p_cascade_to_set_name AS set_name_out, relname AS tablename
+FROM pg_class c
+INNER JOIN pg_namespace n ON n.oid = c.relnamespace
+WHERE p_cascade_to_set_name IS NOT NULL 
+AND n.nspname = 'pglogical_ticker'
+AND c.relkind = 'r'
+AND EXISTS (
+    SELECT 1
+    FROM pglogical.replication_set rsi
+    WHERE rsi.set_name = p_cascade_to_set_name
+);
+
+END;
+$function$
+;
+
+
+CREATE OR REPLACE FUNCTION pglogical_ticker.deploy_ticker_tables(
+--For use with cascading replication, you can pass
+--a set_name in order to add all current subscription tickers 
+--to this replication set
+p_cascade_to_set_name NAME = NULL 
+)
+ RETURNS integer
+ LANGUAGE plpgsql
+AS $function$
+/****
+This will create the main table on both provider and
+all subscriber(s) for in use replication sets.
+
+It assumes this extension is installed both places.
+ */
+DECLARE
+    v_row_count INT;
+BEGIN
+
+PERFORM pglogical.replicate_ddl_command($$
+CREATE TABLE IF NOT EXISTS pglogical_ticker.$$||quote_ident(tablename)||$$ (
+  provider_name        NAME PRIMARY KEY,
+  source_time          TIMESTAMPTZ
+);
+
+SELECT pglogical_ticker.add_ext_object(
+'TABLE',
+format('%s.%s',
+      'pglogical_ticker',
+      quote_ident($$||quote_literal(tablename)||$$)
+      )
+);
+$$, ARRAY[set_name])
+FROM pglogical_ticker.eligible_tickers(p_cascade_to_set_name);
+
+GET DIAGNOSTICS v_row_count = ROW_COUNT;
+RETURN v_row_count;
+
+END;
+$function$
+;
+
+
+CREATE OR REPLACE FUNCTION pglogical_ticker.add_ticker_tables_to_replication(
+--For use with cascading replication, you can pass
+--a set_name in order to add all current subscription tickers
+--to this replication set
+p_cascade_to_set_name NAME = NULL
+)
+ RETURNS integer
+ LANGUAGE plpgsql
+AS $function$
+DECLARE v_row_count INT;
+BEGIN
+/****
+This will add all ticker tables
+to replication if not done already.
+
+It assumes of course pglogical_ticker.deploy_ticker_tables()
+has been run.
+ */
+PERFORM et.set_name, pglogical.replication_set_add_table(
+  set_name:=et.set_name
+  ,relation:=('pglogical_ticker.'||quote_ident(et.tablename))::REGCLASS
+  --default synchronize_data is false
+  ,synchronize_data:=false
+)
+FROM pglogical_ticker.eligible_tickers(p_cascade_to_set_name) et
+WHERE NOT EXISTS
+  (SELECT 1
+  FROM pglogical_ticker.rep_set_table_wrapper() rsr
+  INNER JOIN pglogical.replication_set rs ON rs.set_id = rsr.set_id
+  WHERE rsr.set_reloid = ('pglogical_ticker.'||quote_ident(et.tablename))::REGCLASS 
+    AND et.set_name = rs.set_name);
+
+GET DIAGNOSTICS v_row_count = ROW_COUNT;
+RETURN v_row_count;
+
+END;
+$function$
+;
+
+
+CREATE OR REPLACE FUNCTION pglogical_ticker.tick()
+ RETURNS void
+ LANGUAGE plpgsql
+AS $function$
+DECLARE 
+    v_record RECORD;
+    v_sql TEXT;
+    v_row_count INT;
+BEGIN
+
+FOR v_record IN
+    SELECT rs.set_name
+    FROM pglogical.replication_set rs
+    /***
+    Don't try to tick tables that don't yet exist.  This will allow
+    us to create replication sets without worrying about adding a ticker table
+    immediately.
+    ***/
+    WHERE EXISTS
+        (SELECT 1
+        FROM pg_class c
+        INNER JOIN pg_namespace n ON n.oid = c.relnamespace
+        WHERE n.nspname = 'pglogical_ticker'
+          AND c.relname = rs.set_name
+          /***
+          Also avoid uselessly ticking tables that are not in any replication set
+          (regardless of which one)
+          ***/
+          AND EXISTS
+            (SELECT 1
+            FROM pglogical_ticker.rep_set_table_wrapper() rst
+            WHERE c.oid = rst.set_reloid) 
+        )
+    ORDER BY rs.set_name
+LOOP
+
+    v_sql:=$$
+    INSERT INTO pglogical_ticker.$$||quote_ident(v_record.set_name)||$$ (provider_name, source_time)
+    SELECT ni.if_name, now() AS source_time
+    FROM pglogical.replication_set rs
+    INNER JOIN pglogical.node n ON n.node_id = rs.set_nodeid
+    INNER JOIN pglogical.node_interface ni ON ni.if_nodeid = n.node_id
+    WHERE rs.set_name = '$$||quote_ident(v_record.set_name)||$$'
+    ON CONFLICT (provider_name)
+    DO UPDATE
+    SET source_time = now();
+    $$;
+
+    EXECUTE v_sql;
+
+END LOOP;
+
+END;
+$function$
+;
+
+
+/* pglogical_ticker--1.4--1.5.sql */
+
+-- complain if script is sourced in psql, rather than via CREATE EXTENSION
+\echo Use "CREATE EXTENSION pglogical_ticker" to load this file. \quit
+
+CREATE OR REPLACE FUNCTION pglogical_ticker.launch()
+ RETURNS integer
+ LANGUAGE sql
+ STRICT
+AS $function$
+SELECT pglogical_ticker._launch(oid)
+FROM pg_database
+WHERE datname = current_database()
+--This should be improved in the future but should do 
+--the job for now.
+AND NOT EXISTS
+    (SELECT 1
+    FROM pg_stat_activity psa
+    WHERE NOT pid = pg_backend_pid()
+      AND psa.datname = current_database()
+      AND application_name LIKE 'pglogical_ticker%')
+AND NOT pg_is_in_recovery();
+$function$
+;
+
+
+CREATE OR REPLACE FUNCTION pglogical_ticker.worker_status()
+ RETURNS TABLE(database name, set_name name, worker_pid integer, last_tick_time timestamp with time zone, last_tick_duration_ms double precision, last_commit_lsn pg_lsn, consecutive_errors bigint, tick_interval_ms double precision)
+ LANGUAGE c
+AS '$libdir/pglogical_ticker', $function$pglogical_ticker_worker_status$function$
+;
+
+
+CREATE OR REPLACE FUNCTION pglogical_ticker.worker_stats()
+ RETURNS TABLE(database name, worker_pid integer, interval_ms double precision, ticks bigint, late_ticks bigint, missed_ticks bigint)
+ LANGUAGE c
+AS '$libdir/pglogical_ticker', $function$pglogical_ticker_worker_stats$function$
+;
+
+
+CREATE OR REPLACE FUNCTION pglogical_ticker.set_config_changed()
+ RETURNS trigger
+ LANGUAGE c
+AS '$libdir/pglogical_ticker', $function$pglogical_ticker_set_config_changed$function$
+;
+
+
+CREATE OR REPLACE FUNCTION pglogical_ticker.eligible_tickers
+(
+/***
+"Eligible tickers" are defined as replication sets and tables
+that are eligible to be created or added to replication, either
+because the replication sets exist, or with cascading replication,
+the tables already exist to add to a specified replication set 
+p_cascade_to_set_name as cascaded tickers.
+***/
+p_cascade_to_set_name NAME = NULL 
+)
+ RETURNS TABLE (set_name name, tablename name) 
+ LANGUAGE plpgsql
+AS $function$
+/****
+It assumes this extension is installed both places!
+ */
+BEGIN
+
+RETURN QUERY
+--In the generic case, always tablename = set_name 
+SELECT rs.set_name, rs.set_name AS tablename
+FROM pglogical.replication_set rs
+WHERE p_cascade_to_set_name IS NULL
+UNION
+--For cascading replication, we override set_name
+SELECT p_cascade_to_set_name AS set_name_out, relname AS tablename
+FROM pg_class c
+INNER JOIN pg_namespace n ON n.oid = c.relnamespace
+WHERE p_cascade_to_set_name IS NOT NULL 
+AND n.nspname = 'pglogical_ticker'
+AND c.relkind = 'r'
+--Only ticker tables, not other tables of the extension such as set_config
+AND EXISTS (
+    SELECT 1
+    FROM pg_attribute a
+    WHERE a.attrelid = c.oid
+      AND a.attname = 'source_time'
+      AND NOT a.attisdropped
+)
+AND EXISTS (
+    SELECT 1
+    FROM pglogical.replication_set rsi
+    WHERE rsi.set_name = p_cascade_to_set_name
+);
+
+END;
+$function$
+;
+
+
+DROP FUNCTION pglogical_ticker.deploy_ticker_tables(NAME);
+CREATE OR REPLACE FUNCTION pglogical_ticker.deploy_ticker_tables(
+--For use with cascading replication, you can pass
+--a set_name in order to add all current subscription tickers 
+--to this replication set
+p_cascade_to_set_name NAME = NULL,
+--Install the apply trigger, which logs every tick applied on
+--subscribers, see pglogical_ticker.apply_events()
+p_apply_trigger BOOLEAN = FALSE,
+--Create new tables as partitions of pglogical_ticker.ticks,
+--which needs PostgreSQL 10 or later
+p_partitioned BOOLEAN = FALSE,
+--Replicate the DDL of up to this many tables per command,
+--instead of one command per table
+p_batch_size INT = NULL,
+--Only deploy the tables of these replication sets
+p_set_names NAME[] = NULL
+)
+ RETURNS integer
+ LANGUAGE plpgsql
+AS $function$
+/****
+This will create the main table on both provider and
+all subscriber(s) for in use replication sets.
+
+It assumes this extension is installed both places.
+
+Every tick updates source_time of the same rows, so tables are
+created with room on each page for the new row versions, which makes
+every tick a HOT update that page pruning cleans up.  source_time must
+never be indexed for this to hold.  As pruning keeps the tables small,
+autovacuum hardly needs to visit them.  Tables which already exist get
+the same settings.
+
+Tables deployed before version 1.5 get the prev_tick_lsn column,
+which the worker fills with the commit LSN of its previous tick.
+
+With p_partitioned, tables which do not exist yet are created as
+partitions of pglogical_ticker.ticks, see migrate_to_ticks().
+
+With p_apply_trigger, the tables get a trigger which only fires for
+changes applied by pglogical, and logs the local time each tick was
+applied at.  This needs version 1.5 of the extension on subscribers.
+
+With p_batch_size, the DDL of up to that many tables, in set name order,
+is sent as one command replicated to all of their sets, so that deploying
+many sets queues few DDL messages.  A provider does not know which sets
+each of its subscribers takes, so a subscriber of any set of a batch
+creates the tables of the whole batch.  Those of sets it does not
+subscribe to stay empty, as nothing replicates or ticks them there.
+
+With p_set_names, only the tables of those replication sets are
+deployed, see provision_ticker_tables().
+ */
+DECLARE
+    v_row_count INT = 0;
+    v_commands INT = 0;
+    v_batch RECORD;
+    v_storage TEXT = 'fillfactor = 10,
+  autovacuum_vacuum_scale_factor = 0,
+  autovacuum_vacuum_threshold = 10000,
+  autovacuum_analyze_scale_factor = 0,
+  autovacuum_analyze_threshold = 100000';
+BEGIN
+
+IF p_batch_size < 1 THEN
+    RAISE EXCEPTION 'p_batch_size must be at least 1';
+END IF;
+
+IF p_partitioned AND to_regclass('pglogical_ticker.ticks') IS NULL THEN
+    RAISE EXCEPTION 'pglogical_ticker.ticks requires PostgreSQL 10 or later';
+END IF;
+
+FOR v_batch IN
+SELECT string_agg(d.ddl, '' ORDER BY d.rn)||$$
+SELECT pglogical_ticker.add_ext_object(
+'TABLE',
+format('%s.%s',
+      'pglogical_ticker',
+      quote_ident(t)
+      )
+)
+FROM unnest($$||quote_literal(array_agg(d.tablename ORDER BY d.rn)::TEXT)||$$::NAME[]) t;
+$$ AS ddl,
+  array_agg(DISTINCT d.set_name::TEXT) AS set_names,
+  count(1) AS tables
+FROM (SELECT t.set_name,
+  t.tablename,
+  row_number() OVER (ORDER BY t.set_name, t.tablename) AS rn,
+  t.ddl
+FROM (SELECT et.set_name,
+  et.tablename,
+CASE WHEN p_partitioned THEN $$
+CREATE TABLE IF NOT EXISTS pglogical_ticker.$$||quote_ident(tablename)||$$
+PARTITION OF pglogical_ticker.ticks (
+  set_name DEFAULT $$||quote_literal(tablename)||$$,
+  PRIMARY KEY (provider_name)
+) FOR VALUES IN ($$||quote_literal(tablename)||$$)
+WITH ($$||v_storage||$$);
+$$ ELSE $$
+CREATE TABLE IF NOT EXISTS pglogical_ticker.$$||quote_ident(tablename)||$$ (
+  provider_name        NAME PRIMARY KEY,
+  source_time          TIMESTAMPTZ
+) WITH ($$||v_storage||$$);
+$$ END||$$
+ALTER TABLE pglogical_ticker.$$||quote_ident(tablename)||$$ SET ($$||v_storage||$$);
+$$||CASE WHEN NOT EXISTS
+    (SELECT 1
+    FROM pg_attribute a
+    INNER JOIN pg_class c ON c.oid = a.attrelid
+    INNER JOIN pg_namespace n ON n.oid = c.relnamespace
+    WHERE n.nspname = 'pglogical_ticker'
+      AND c.relname = tablename
+      AND a.attname = 'prev_tick_lsn'
+      AND NOT a.attisdropped)
+  --New partitions get the column from pglogical_ticker.ticks
+  AND (NOT p_partitioned OR EXISTS
+    (SELECT 1
+    FROM pg_class c
+    INNER JOIN pg_namespace n ON n.oid = c.relnamespace
+    WHERE n.nspname = 'pglogical_ticker'
+      AND c.relname = tablename)) THEN $$
+ALTER TABLE pglogical_ticker.$$||quote_ident(tablename)||$$ ADD COLUMN prev_tick_lsn PG_LSN;
+$$ ELSE '' END||CASE WHEN p_apply_trigger THEN $$
+DROP TRIGGER IF EXISTS apply_trigger ON pglogical_ticker.$$||quote_ident(tablename)||$$;
+CREATE TRIGGER apply_trigger
+BEFORE INSERT OR UPDATE ON pglogical_ticker.$$||quote_ident(tablename)||$$
+FOR EACH ROW EXECUTE PROCEDURE pglogical_ticker.apply_trigger();
+ALTER TABLE pglogical_ticker.$$||quote_ident(tablename)||$$ ENABLE REPLICA TRIGGER apply_trigger;
+$$ ELSE '' END AS ddl
+  FROM pglogical_ticker.eligible_tickers(p_cascade_to_set_name) et
+  WHERE p_set_names IS NULL OR et.set_name = ANY(p_set_names)) t) d
+GROUP BY CASE WHEN p_batch_size IS NULL THEN d.rn ELSE (d.rn - 1) / p_batch_size END
+LOOP
+    PERFORM pglogical.replicate_ddl_command(v_batch.ddl, v_batch.set_names);
+    v_commands = v_commands + 1;
+    v_row_count = v_row_count + v_batch.tables;
+END LOOP;
+
+IF p_batch_size IS NOT NULL THEN
+    RAISE NOTICE 'deployed % ticker tables in % DDL commands, saving % queue entries',
+        v_row_count, v_commands, v_row_count - v_commands;
+END IF;
+
+RETURN v_row_count;
+
+END;
+$function$
+;
+
+
+CREATE OR REPLACE FUNCTION pglogical_ticker.ticker_table_stats()
+ RETURNS TABLE(tablename name, updates bigint, hot_updates bigint, hot_ratio numeric, dead_tuples bigint, pages bigint, last_autovacuum timestamp with time zone)
+ LANGUAGE sql
+ STABLE
+AS $function$
+/****
+Bloat telemetry of the ticker tables.  With the layout created by
+deploy_ticker_tables(), hot_ratio should stay at 1 and pages at 1.
+ */
+SELECT c.relname,
+  pg_stat_get_tuples_updated(c.oid),
+  pg_stat_get_tuples_hot_updated(c.oid),
+  round(pg_stat_get_tuples_hot_updated(c.oid)::NUMERIC
+    / NULLIF(pg_stat_get_tuples_updated(c.oid), 0), 4),
+  pg_stat_get_dead_tuples(c.oid),
+  pg_relation_size(c.oid) / current_setting('block_size')::BIGINT,
+  pg_stat_get_last_autovacuum_time(c.oid)
+FROM pg_class c
+INNER JOIN pg_namespace n ON n.oid = c.relnamespace
+WHERE n.nspname = 'pglogical_ticker'
+  AND c.relkind = 'r'
+  AND EXISTS (
+    SELECT 1
+    FROM pg_attribute a
+    WHERE a.attrelid = c.oid
+      AND a.attname = 'source_time'
+      AND NOT a.attisdropped)
+ORDER BY c.relname;
+$function$
+;
+
+
+CREATE OR REPLACE FUNCTION pglogical_ticker.lag()
+ RETURNS TABLE(provider_name name, set_name name, source_time timestamp with time zone, lag interval, staleness interval)
+ LANGUAGE c
+AS '$libdir/pglogical_ticker', $function$pglogical_ticker_lag$function$
+;
+
+
+CREATE OR REPLACE FUNCTION pglogical_ticker.lag_histogram()
+ RETURNS TABLE(database name, provider_name name, set_name name, since timestamp with time zone, samples bigint, p50_ms double precision, p90_ms double precision, p99_ms double precision, max_ms double precision)
+ LANGUAGE c
+AS '$libdir/pglogical_ticker', $function$pglogical_ticker_lag_histogram$function$
+;
+
+
+CREATE OR REPLACE FUNCTION pglogical_ticker.lag_histogram_reset(p_set_name name = NULL)
+ RETURNS void
+ LANGUAGE c
+AS '$libdir/pglogical_ticker', $function$pglogical_ticker_lag_histogram_reset$function$
+;
+
+
+CREATE OR REPLACE FUNCTION pglogical_ticker.apply_trigger()
+ RETURNS trigger
+ LANGUAGE c
+AS '$libdir/pglogical_ticker', $function$pglogical_ticker_apply_trigger$function$
+;
+
+
+CREATE OR REPLACE FUNCTION pglogical_ticker.apply_events()
+ RETURNS TABLE(database name, provider_name name, set_name name, source_time timestamp with time zone, apply_time timestamp with time zone, apply_lag interval)
+ LANGUAGE c
+AS '$libdir/pglogical_ticker', $function$pglogical_ticker_apply_events$function$
+;
+
+
+CREATE OR REPLACE FUNCTION pglogical_ticker.lag_history_add_partition(
+p_table NAME,
+--day, month or year
+p_unit TEXT,
+p_time TIMESTAMPTZ
+)
+ RETURNS void
+ LANGUAGE plpgsql
+AS $function$
+/****
+Create the partition of a lag history table that covers p_time.
+Partitions are bounded on UTC days, months or years, whatever the
+time zone of the session, and are named after their start.
+ */
+DECLARE
+    v_start TIMESTAMP = date_trunc(p_unit, p_time AT TIME ZONE 'UTC');
+    v_end TIMESTAMP = v_start + ('1 '||p_unit)::INTERVAL;
+BEGIN
+
+EXECUTE format('CREATE TABLE IF NOT EXISTS pglogical_ticker.%I
+PARTITION OF pglogical_ticker.%I
+FOR VALUES FROM (%L) TO (%L)',
+    p_table||'_p'||to_char(v_start, CASE p_unit
+                                         WHEN 'day' THEN 'YYYYMMDD'
+                                         WHEN 'month' THEN 'YYYYMM'
+                                         ELSE 'YYYY'
+                                     END),
+    p_table,
+    to_char(v_start, 'YYYY-MM-DD HH24:MI:SS')||'+00',
+    to_char(v_end, 'YYYY-MM-DD HH24:MI:SS')||'+00');
+
+END;
+$function$
+;
+
+
+CREATE OR REPLACE FUNCTION pglogical_ticker.lag_history_maintenance(
+--Default to pglogical_ticker.lag_history_retention_days
+p_raw_retention INTERVAL = NULL,
+--Default to pglogical_ticker.lag_history_rollup_retention_days
+p_rollup_retention INTERVAL = NULL
+)
+ RETURNS void
+ LANGUAGE plpgsql
+AS $function$
+/****
+This is run every hour by the worker when pglogical_ticker.lag_history
+is on.  It:
+- creates the partitions needed until tomorrow
+- rolls the raw samples of complete minutes up into lag_history_1m, and
+  those of complete hours up into lag_history_1h
+- drops the partitions of raw samples and of 1 minute aggregates which
+  are past their retention.  Hourly aggregates are kept.
+
+Expired data is only ever dropped a partition at a time, so history
+costs no DELETE and no vacuum.
+ */
+DECLARE
+    v_now TIMESTAMPTZ = now();
+    v_from TIMESTAMPTZ;
+    v_until TIMESTAMPTZ;
+    v_end TIMESTAMPTZ;
+    v_part RECORD;
+BEGIN
+
+IF to_regclass('pglogical_ticker.lag_history') IS NULL THEN
+    RAISE EXCEPTION 'lag history requires PostgreSQL 10 or later';
+END IF;
+
+p_raw_retention = COALESCE(p_raw_retention,
+    make_interval(days := COALESCE(NULLIF(current_setting('pglogical_ticker.lag_history_retention_days', true), ''), '7')::INT));
+p_rollup_retention = COALESCE(p_rollup_retention,
+    make_interval(days := COALESCE(NULLIF(current_setting('pglogical_ticker.lag_history_rollup_retention_days', true), ''), '90')::INT));
+
+PERFORM pglogical_ticker.lag_history_add_partition('lag_history', 'day', v_now);
+PERFORM pglogical_ticker.lag_history_add_partition('lag_history', 'day', v_now + INTERVAL '1 day');
+PERFORM pglogical_ticker.lag_history_add_partition('lag_history_1m', 'month', v_now);
+PERFORM pglogical_ticker.lag_history_add_partition('lag_history_1m', 'month', v_now + INTERVAL '1 day');
+PERFORM pglogical_ticker.lag_history_add_partition('lag_history_1h', 'year', v_now);
+PERFORM pglogical_ticker.lag_history_add_partition('lag_history_1h', 'year', v_now + INTERVAL '1 day');
+
+--Samples are written in batches, so leave a minute for the last ones to arrive
+SELECT max(bucket) + INTERVAL '1 minute' INTO v_from FROM pglogical_ticker.lag_history_1m;
+v_until = date_trunc('minute', (v_now - INTERVAL '1 minute') AT TIME ZONE 'UTC') AT TIME ZONE 'UTC';
+
+INSERT INTO pglogical_ticker.lag_history_1m
+    (bucket, provider_name, set_name, samples, avg_lag, max_lag)
+SELECT date_trunc('minute', sample_time AT TIME ZONE 'UTC') AT TIME ZONE 'UTC',
+    provider_name, set_name, count(1), avg(lag), max(lag)
+FROM pglogical_ticker.lag_history
+WHERE sample_time >= COALESCE(v_from, '-infinity')
+  AND sample_time < v_until
+GROUP BY 1, 2, 3;
+
+SELECT max(bucket) + INTERVAL '1 hour' INTO v_from FROM pglogical_ticker.lag_history_1h;
+v_until = date_trunc('hour', v_until AT TIME ZONE 'UTC') AT TIME ZONE 'UTC';
+
+INSERT INTO pglogical_ticker.lag_history_1h
+    (bucket, provider_name, set_name, samples, avg_lag, max_lag)
+SELECT date_trunc('hour', bucket AT TIME ZONE 'UTC') AT TIME ZONE 'UTC',
+    provider_name, set_name, sum(samples),
+    sum(avg_lag * samples::FLOAT8) / sum(samples)::FLOAT8, max(max_lag)
+FROM pglogical_ticker.lag_history_1m
+WHERE bucket >= COALESCE(v_from, '-infinity')
+  AND bucket < v_until
+GROUP BY 1, 2, 3;
+
+FOR v_part IN
+    SELECT c.relname, p.relname AS parent
+    FROM pg_inherits i
+    INNER JOIN pg_class c ON c.oid = i.inhrelid
+    INNER JOIN pg_class p ON p.oid = i.inhparent
+    INNER JOIN pg_namespace n ON n.oid = p.relnamespace
+    WHERE n.nspname = 'pglogical_ticker'
+      AND p.relname IN ('lag_history', 'lag_history_1m')
+LOOP
+    IF v_part.parent = 'lag_history' THEN
+        v_end = (to_date(right(v_part.relname, 8), 'YYYYMMDD') + INTERVAL '1 day') AT TIME ZONE 'UTC';
+        CONTINUE WHEN v_end > v_now - p_raw_retention;
+    ELSE
+        v_end = (to_date(right(v_part.relname, 6), 'YYYYMM') + INTERVAL '1 month') AT TIME ZONE 'UTC';
+        CONTINUE WHEN v_end > v_now - p_rollup_retention;
+    END IF;
+
+    EXECUTE format('DROP TABLE pglogical_ticker.%I', v_part.relname);
+END LOOP;
+
+END;
+$function$
+;
+
+
+CREATE OR REPLACE FUNCTION pglogical_ticker.metrics()
+ RETURNS text
+ LANGUAGE c
+AS '$libdir/pglogical_ticker', $function$pglogical_ticker_metrics$function$
+;
+
+
+CREATE OR REPLACE FUNCTION pglogical_ticker.tick_phase_stats()
+ RETURNS TABLE(database name, phase text, calls bigint, total_ms double precision, avg_ms double precision, recent_avg_ms double precision, max_ms double precision, last_ms double precision)
+ LANGUAGE c
+AS '$libdir/pglogical_ticker', $function$pglogical_ticker_tick_phase_stats$function$
+;
+
+
+CREATE OR REPLACE FUNCTION pglogical_ticker.tick_commits()
+ RETURNS TABLE(database name, tick_time timestamp with time zone, commit_lsn pg_lsn)
+ LANGUAGE c
+AS '$libdir/pglogical_ticker', $function$pglogical_ticker_tick_commits$function$
+;
+
+
+CREATE OR REPLACE FUNCTION pglogical_ticker.all_repset_tickers()
+ RETURNS TABLE(provider_name name, set_name name, source_time timestamp with time zone)
+ LANGUAGE c
+AS '$libdir/pglogical_ticker', $function$pglogical_ticker_all_repset_tickers$function$
+;
+
+
+CREATE OR REPLACE FUNCTION pglogical_ticker.all_subscription_tickers()
+ RETURNS TABLE(provider_name name, set_name name, source_time timestamp with time zone)
+ LANGUAGE c
+AS '$libdir/pglogical_ticker', $function$pglogical_ticker_all_subscription_tickers$function$
+;
+
+
+CREATE OR REPLACE FUNCTION pglogical_ticker.tick_rep_set(p_set_name name)
+ RETURNS integer
+ LANGUAGE plpgsql
+AS $function$
+DECLARE
+    v_sql TEXT;
+BEGIN
+
+v_sql:=$$
+INSERT INTO pglogical_ticker.$$||quote_ident(p_set_name)||$$ (provider_name, source_time)
+SELECT ni.if_name, now() AS source_time
+FROM pglogical.replication_set rs
+INNER JOIN pglogical.node n ON n.node_id = rs.set_nodeid
+INNER JOIN pglogical.node_interface ni ON ni.if_nodeid = n.node_id
+WHERE rs.set_name = $$||quote_literal(p_set_name)||$$
+ON CONFLICT (provider_name)
+DO UPDATE
+SET source_time = now();
+$$;
+
+EXECUTE v_sql;
+RETURN NULL;
+
+END;
+$function$
+;
+
+
+CREATE OR REPLACE FUNCTION pglogical_ticker.migrate_to_ticks()
+ RETURNS integer
+ LANGUAGE plpgsql
+AS $function$
+/****
+Attach every ticker table in replication as a partition of
+pglogical_ticker.ticks, on the provider and, through
+pglogical.replicate_ddl_command, on subscribers.
+
+Tables are attached in place: they keep their name, their replication
+sets and their rows, and only get a set_name column which defaults to the
+table name.  migrate_from_ticks() reverses this.
+ */
+DECLARE
+    v_row_count INT;
+BEGIN
+
+IF to_regclass('pglogical_ticker.ticks') IS NULL THEN
+    RAISE EXCEPTION 'pglogical_ticker.ticks requires PostgreSQL 10 or later';
+END IF;
+
+PERFORM pglogical.replicate_ddl_command($$
+ALTER TABLE pglogical_ticker.$$||quote_ident(t.relname)||$$ ADD COLUMN IF NOT EXISTS prev_tick_lsn PG_LSN;
+ALTER TABLE pglogical_ticker.$$||quote_ident(t.relname)||$$ ADD COLUMN set_name NAME NOT NULL DEFAULT $$||quote_literal(t.relname)||$$;
+ALTER TABLE pglogical_ticker.ticks ATTACH PARTITION pglogical_ticker.$$||quote_ident(t.relname)||$$ FOR VALUES IN ($$||quote_literal(t.relname)||$$);
+$$, t.set_names)
+FROM (SELECT c.relname, array_agg(rs.set_name::TEXT ORDER BY rs.set_name) AS set_names
+    FROM pg_class c
+    INNER JOIN pg_namespace n ON n.oid = c.relnamespace
+    INNER JOIN pglogical_ticker.rep_set_table_wrapper() rst ON rst.set_reloid = c.oid
+    INNER JOIN pglogical.replication_set rs ON rs.set_id = rst.set_id
+    WHERE n.nspname = 'pglogical_ticker'
+      AND c.relkind = 'r'
+      AND NOT c.relispartition
+      AND EXISTS (
+        SELECT 1
+        FROM pg_attribute a
+        WHERE a.attrelid = c.oid
+          AND a.attname = 'source_time'
+          AND NOT a.attisdropped
+      )
+    GROUP BY c.relname) t;
+
+GET DIAGNOSTICS v_row_count = ROW_COUNT;
+RETURN v_row_count;
+
+END;
+$function$
+;
+
+
+CREATE OR REPLACE FUNCTION pglogical_ticker.migrate_from_ticks()
+ RETURNS integer
+ LANGUAGE plpgsql
+AS $function$
+/****
+Detach every partition of pglogical_ticker.ticks which is in replication
+back into a ticker table of its own, on the provider and, through
+pglogical.replicate_ddl_command, on subscribers.  This reverses
+migrate_to_ticks(), and works as well for partitions created by
+deploy_ticker_tables(p_partitioned := true).
+ */
+DECLARE
+    v_row_count INT;
+BEGIN
+
+IF to_regclass('pglogical_ticker.ticks') IS NULL THEN
+    RAISE EXCEPTION 'pglogical_ticker.ticks requires PostgreSQL 10 or later';
+END IF;
+
+PERFORM pglogical.replicate_ddl_command($$
+ALTER TABLE pglogical_ticker.ticks DETACH PARTITION pglogical_ticker.$$||quote_ident(t.relname)||$$;
+ALTER TABLE pglogical_ticker.$$||quote_ident(t.relname)||$$ DROP COLUMN set_name;
+$$, t.set_names)
+FROM (SELECT c.relname, array_agg(rs.set_name::TEXT ORDER BY rs.set_name) AS set_names
+    FROM pg_inherits i
+    INNER JOIN pg_class c ON c.oid = i.inhrelid
+    INNER JOIN pglogical_ticker.rep_set_table_wrapper() rst ON rst.set_reloid = c.oid
+    INNER JOIN pglogical.replication_set rs ON rs.set_id = rst.set_id
+    WHERE i.inhparent = 'pglogical_ticker.ticks'::REGCLASS
+    GROUP BY c.relname) t;
+
+GET DIAGNOSTICS v_row_count = ROW_COUNT;
+RETURN v_row_count;
+
+END;
+$function$
+;
+
+
+CREATE OR REPLACE FUNCTION pglogical_ticker.tick_now(set_names name[])
+ RETURNS TABLE(source_time timestamp with time zone, commit_time timestamp with time zone, commit_lsn pg_lsn)
+ LANGUAGE c
+ STRICT
+AS '$libdir/pglogical_ticker', $function$pglogical_ticker_tick_now$function$
+;
+
+
+CREATE OR REPLACE FUNCTION pglogical_ticker.ticker_tables_to_add(
+--Same as for add_ticker_tables_to_replication()
+p_cascade_to_set_name NAME = NULL
+)
+ RETURNS TABLE (set_name name, relation regclass)
+ LANGUAGE sql
+ STABLE
+AS $function$
+/****
+The ticker tables add_ticker_tables_to_replication() would add to
+replication, which makes for a dry run of it.
+
+Membership of the replication sets is read once, and the eligible
+tickers are anti-joined to it, instead of reading it again for
+every ticker.
+ */
+WITH membership AS (
+  SELECT rs.set_name, rsr.set_reloid
+  FROM pglogical_ticker.rep_set_table_wrapper() rsr
+  INNER JOIN pglogical.replication_set rs ON rs.set_id = rsr.set_id
+)
+, eligible AS (
+  SELECT et.set_name, ('pglogical_ticker.'||quote_ident(et.tablename))::REGCLASS AS relation
+  FROM pglogical_ticker.eligible_tickers(p_cascade_to_set_name) et
+)
+SELECT e.set_name, e.relation
+FROM eligible e
+WHERE NOT EXISTS
+  (SELECT 1
+  FROM membership m
+  WHERE m.set_reloid = e.relation
+    AND m.set_name = e.set_name)
+ORDER BY e.set_name, e.relation::TEXT;
+$function$
+;
+
+
+CREATE OR REPLACE FUNCTION pglogical_ticker.add_ticker_tables_to_replication(
+--For use with cascading replication, you can pass
+--a set_name in order to add all current subscription tickers
+--to this replication set
+p_cascade_to_set_name NAME = NULL
+)
+ RETURNS integer
+ LANGUAGE plpgsql
+AS $function$
+DECLARE v_row_count INT;
+BEGIN
+/****
+This will add all ticker tables
+to replication if not done already.
+
+It assumes of course pglogical_ticker.deploy_ticker_tables()
+has been run.  See ticker_tables_to_add() for the tables
+this would add.
+ */
+PERFORM pglogical.replication_set_add_table(
+  set_name:=t.set_name
+  ,relation:=t.relation
+  --default synchronize_data is false
+  ,synchronize_data:=false
+)
+FROM pglogical_ticker.ticker_tables_to_add(p_cascade_to_set_name) t;
+
+GET DIAGNOSTICS v_row_count = ROW_COUNT;
+RETURN v_row_count;
+
+END;
+$function$
+;
+
+
+CREATE OR REPLACE FUNCTION pglogical_ticker.provision_ticker_tables(p_set_names NAME[])
+ RETURNS integer
+ LANGUAGE plpgsql
+AS $function$
+/****
+Deploy the ticker tables of the given replication sets which have none
+yet, and add them to their set, as deploy_ticker_tables() and
+add_ticker_tables_to_replication() do for all sets.  The worker calls
+this for new replication sets with pglogical_ticker.auto_provision.
+
+Sets which already have a ticker table are left alone, so no DDL is
+queued for them.  A set that cannot be provisioned only gets a warning,
+so that it does not keep the others from being provisioned; the worker
+tries it again later.
+ */
+DECLARE
+    v_set_name NAME;
+    v_row_count INT = 0;
+BEGIN
+
+FOR v_set_name IN
+    SELECT rs.set_name
+    FROM pglogical.replication_set rs
+    WHERE rs.set_name = ANY(p_set_names)
+      AND NOT EXISTS
+        (SELECT 1
+        FROM pg_class c
+        INNER JOIN pg_namespace n ON n.oid = c.relnamespace
+        WHERE n.nspname = 'pglogical_ticker'
+          AND c.relname = rs.set_name)
+    ORDER BY rs.set_name
+LOOP
+    BEGIN
+        PERFORM pglogical_ticker.deploy_ticker_tables(p_set_names := ARRAY[v_set_name]);
+        PERFORM pglogical.replication_set_add_table(
+          set_name:=v_set_name
+          ,relation:=('pglogical_ticker.'||quote_ident(v_set_name))::REGCLASS
+          ,synchronize_data:=false
+        );
+        v_row_count = v_row_count + 1;
+    EXCEPTION WHEN OTHERS THEN
+        RAISE WARNING 'pglogical_ticker: could not provision ticker table of replication set "%": %',
+            v_set_name, SQLERRM;
+    END;
+END LOOP;
+
+RETURN v_row_count;
+
+END;
+$function$
+;
+
+
+--Per replication set tick settings of the background worker.  Sets without
+--an entry here are ticked every pglogical_ticker.naptime.
+CREATE TABLE pglogical_ticker.set_config (
+    set_name NAME PRIMARY KEY,
+    tick_interval INTERVAL CHECK (tick_interval >= INTERVAL '1 millisecond'),
+    enabled BOOLEAN NOT NULL DEFAULT TRUE
+);
+SELECT pg_catalog.pg_extension_config_dump('pglogical_ticker.set_config', '');
+
+--Let the workers know they have to re-read the configuration
+CREATE TRIGGER set_config_changed
+AFTER INSERT OR UPDATE OR DELETE OR TRUNCATE ON pglogical_ticker.set_config
+FOR EACH STATEMENT EXECUTE PROCEDURE pglogical_ticker.set_config_changed();
+
+--Lag history, sampled by the worker on subscribers with
+--pglogical_ticker.lag_history on.  This needs declarative partitioning.
+DO $block$
+BEGIN
+IF current_setting('server_version_num')::INT >= 100000 THEN
+
+EXECUTE $$
+CREATE TABLE pglogical_ticker.lag_history (
+    sample_time TIMESTAMPTZ NOT NULL,
+    provider_name NAME NOT NULL,
+    set_name NAME NOT NULL,
+    lag INTERVAL NOT NULL
+) PARTITION BY RANGE (sample_time)
+$$;
+
+EXECUTE $$
+CREATE TABLE pglogical_ticker.lag_history_1m (
+    bucket TIMESTAMPTZ NOT NULL,
+    provider_name NAME NOT NULL,
+    set_name NAME NOT NULL,
+    samples BIGINT NOT NULL,
+    avg_lag INTERVAL NOT NULL,
+    max_lag INTERVAL NOT NULL
+) PARTITION BY RANGE (bucket)
+$$;
+
+EXECUTE $$
+CREATE TABLE pglogical_ticker.lag_history_1h (
+    bucket TIMESTAMPTZ NOT NULL,
+    provider_name NAME NOT NULL,
+    set_name NAME NOT NULL,
+    samples BIGINT NOT NULL,
+    avg_lag INTERVAL NOT NULL,
+    max_lag INTERVAL NOT NULL
+) PARTITION BY RANGE (bucket)
+$$;
+
+END IF;
+END
+$block$;
+
+--Optional consolidated layout of the ticker tables, as partitions of a
+--single table, see deploy_ticker_tables() and migrate_to_ticks().
+--Each partition keeps the name of its replication set and its own primary
+--key on provider_name, so ticking and replicating it works as with any
+--ticker table.
+DO $block$
+BEGIN
+IF current_setting('server_version_num')::INT >= 100000 THEN
+
+EXECUTE $$
+CREATE TABLE pglogical_ticker.ticks (
+    provider_name NAME NOT NULL,
+    source_time TIMESTAMPTZ,
+    prev_tick_lsn PG_LSN,
+    set_name NAME NOT NULL
+) PARTITION BY LIST (set_name)
+$$;
+
+END IF;
+END
+$block$;
+
+--Membership of tables in replication sets, from the pglogical catalog
+--table of the installed version, which is only looked up here.  The view
+--is bound to the table, so it follows the rename done by upgrades of
+--pglogical from version 1 to 2.
+DO $block$
+BEGIN
+IF to_regclass('pglogical.replication_set_table') IS NOT NULL THEN
+    EXECUTE $$
+    CREATE VIEW pglogical_ticker.rep_set_table AS
+    SELECT r.set_id, r.set_reloid
+    FROM pglogical.replication_set_table r
+    $$;
+ELSIF to_regclass('pglogical.replication_set_relation') IS NOT NULL THEN
+    EXECUTE $$
+    CREATE VIEW pglogical_ticker.rep_set_table AS
+    SELECT r.set_id, r.set_reloid
+    FROM pglogical.replication_set_relation r
+    $$;
+ELSE
+    RAISE EXCEPTION 'No table pglogical.replication_set_relation or pglogical.replication_set_table found';
+END IF;
+END
+$block$;
+
+
+CREATE OR REPLACE FUNCTION pglogical_ticker.rep_set_table_wrapper()
+ RETURNS TABLE (set_id OID, set_reloid REGCLASS)
+ LANGUAGE sql
+ STABLE
+AS $function$
+/*****
+This handles the rename of pglogical.replication_set_relation to pglogical.replication_set_table from version 1 to 2,
+through the view pglogical_ticker.rep_set_table.  As a STABLE SQL function, it is inlined into the queries calling it.
+ */
+SELECT r.set_id, r.set_reloid::REGCLASS
+FROM pglogical_ticker.rep_set_table r;
+$function$
+;
+
+
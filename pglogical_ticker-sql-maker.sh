@@ -2,8 +2,8 @@
 
 set -eu
 
-last_version=1.3
-new_version=1.4
+last_version=1.4
+new_version=1.5
 last_version_file=pglogical_ticker--${last_version}.sql
 new_version_file=pglogical_ticker--${new_version}.sql
 update_file=pglogical_ticker--${last_version}--${new_version}.sql
@@ -36,9 +36,42 @@ d=$2
 create_update_file_with_header
 
 # Add view and function changes
+# launch() was left out of the 1.4 install script, so carry it again here
 add_file functions/pglogical_ticker.launch.sql $update_file
+add_file functions/pglogical_ticker.worker_status.sql $update_file
+add_file functions/pglogical_ticker.worker_stats.sql $update_file
+add_file functions/pglogical_ticker.set_config_changed.sql $update_file
+add_file functions/pglogical_ticker.eligible_tickers.sql $update_file
+# deploy_ticker_tables() got a new argument, so replace it instead of adding an overload
+add_sql_to_file "DROP FUNCTION pglogical_ticker.deploy_ticker_tables(NAME);" $update_file
+add_file functions/pglogical_ticker.deploy_ticker_tables.sql $update_file
+add_file functions/pglogical_ticker.ticker_table_stats.sql $update_file
+add_file functions/pglogical_ticker.lag.sql $update_file
+add_file functions/pglogical_ticker.lag_histogram.sql $update_file
+add_file functions/pglogical_ticker.lag_histogram_reset.sql $update_file
+add_file functions/pglogical_ticker.apply_trigger.sql $update_file
+add_file functions/pglogical_ticker.apply_events.sql $update_file
+add_file functions/pglogical_ticker.lag_history_add_partition.sql $update_file
+add_file functions/pglogical_ticker.lag_history_maintenance.sql $update_file
+add_file functions/pglogical_ticker.metrics.sql $update_file
+add_file functions/pglogical_ticker.tick_phase_stats.sql $update_file
+add_file functions/pglogical_ticker.tick_commits.sql $update_file
+add_file functions/pglogical_ticker.all_repset_tickers.sql $update_file
+add_file functions/pglogical_ticker.all_subscription_tickers.sql $update_file
+add_file functions/pglogical_ticker.tick_rep_set.sql $update_file
+add_file functions/pglogical_ticker.migrate_to_ticks.sql $update_file
+add_file functions/pglogical_ticker.migrate_from_ticks.sql $update_file
+add_file functions/pglogical_ticker.tick_now.sql $update_file
+add_file functions/pglogical_ticker.ticker_tables_to_add.sql $update_file
+add_file functions/pglogical_ticker.add_ticker_tables_to_replication.sql $update_file
+add_file functions/pglogical_ticker.provision_ticker_tables.sql $update_file
+
+# Add schema changes, which use the functions above
+add_file schema/1.5.sql $update_file
+# rep_set_table_wrapper() now reads the view created by the schema changes
+add_file functions/pglogical_ticker.rep_set_table_wrapper.sql $update_file
 
 # Only copy diff and new files after last version, and add the update script
 touch $update_file
 cp $last_version_file $new_version_file
-#cat $update_file >> $new_version_file
+cat $update_file >> $new_version_file
@@ -18,24 +18,47 @@
 #include "storage/shmem.h"
 
 /* these headers are used by this particular worker's code */
+#include "access/heapam.h"
+#include "access/htup_details.h"
+#include "access/transam.h"
 #include "access/xact.h"
+#include "access/xlog.h"
+#include "catalog/pg_database.h"
+#include "commands/extension.h"
 #include "executor/spi.h"
 #include "fmgr.h"
+#include "funcapi.h"
 #include "lib/stringinfo.h"
 #include "pgstat.h"
+#include "portability/instr_time.h"
 #include "utils/builtins.h"
+#include "utils/guc.h"
+#include "utils/memutils.h"
 #include "utils/snapmgr.h"
+#include "utils/timestamp.h"
 #include "tcop/utility.h"
 
 /* includes for ticker */
 #include "commands/dbcommands.h"
 
+#include "pglogical_ticker.h"
+
+#if PG_VERSION_NUM >= 120000
+#define TickerDatabaseTupleGetOid(tup) \
+	(((Form_pg_database) GETSTRUCT(tup))->oid)
+#else
+#define TickerDatabaseTupleGetOid(tup) HeapTupleGetOid(tup)
+#endif
+
 PG_MODULE_MAGIC;
 
 PG_FUNCTION_INFO_V1(pglogical_ticker_launch);
 
 void		_PG_init(void);
 void		pglogical_ticker_main(Datum) pg_attribute_noreturn();
+void		pglogical_ticker_supervisor_main(Datum) pg_attribute_noreturn();
+
+static bool pglogical_ticker_installed(void);
 
 /* flags set by signal handlers */
 static volatile sig_atomic_t got_sighup = false;
@@ -43,12 +66,61 @@ static volatile sig_atomic_t got_sigterm = false;
 
 /* GUC variables */
 static int  pglogical_ticker_naptime = 10;
+static int  pglogical_ticker_naptime_ms = 0;
 static char *pglogical_ticker_database;
 static int  pglogical_ticker_restart_time = 10;
+static bool pglogical_ticker_autodiscover = false;
+static int  pglogical_ticker_lag_sample_interval_ms = 0;
+static int  pglogical_ticker_lag_history_retention_days = 7;
+static int  pglogical_ticker_lag_history_rollup_retention_days = 90;
+bool		pglogical_ticker_batch_tick = false;
+bool		pglogical_ticker_lag_history = false;
+bool		pglogical_ticker_use_commit_timestamp = false;
+bool		pglogical_ticker_auto_provision = false;
 
 /* Constants */
 static int  pglogical_ticker_total_workers = 1;
 
+/* How often the supervisor looks for new databases */
+#define TICKER_SUPERVISOR_NAPTIME_MS	10000
+
+/*
+ * How long the supervisor waits before rechecking a database without the
+ * extension.  The wait doubles with each recheck that finds it still
+ * missing, up to TICKER_SUPERVISOR_MAX_RECHECKS doublings.
+ */
+#define TICKER_SUPERVISOR_RECHECK_MS	180000
+#define TICKER_SUPERVISOR_MAX_RECHECKS	3
+
+/*
+ * How many workers the supervisor has at most looking at databases not yet
+ * known to have the extension, so that it does not take all of
+ * max_worker_processes on a server with many databases.
+ */
+#define TICKER_SUPERVISOR_MAX_PROBES	2
+
+/* How often the worker runs pglogical_ticker.lag_history_maintenance() */
+#define TICKER_LAG_HISTORY_MAINTENANCE_US	USECS_PER_HOUR
+
+/* Marker in bgw_extra of workers started by the supervisor */
+#define TICKER_WORKER_SUPERVISED		's'
+
+/*
+ * Wait event of each TickerWaitEvent, 0 until ticker_wait_events_init()
+ * registers them.
+ */
+static uint32 ticker_wait_events[TICKER_NUM_WAIT_EVENTS];
+
+/* A database the supervisor manages a ticker for */
+typedef struct TickerDbWorker
+{
+	Oid			dbid;
+	BackgroundWorkerHandle *handle; /* NULL if never started */
+	TimestampTz last_start;		/* or since when another ticker runs */
+	int			rechecks;		/* rechecks which found no extension */
+	bool		seen;			/* still in pg_database */
+} TickerDbWorker;
+
 /*
  * Signal handler for SIGTERM
  *		Set a flag to let the main loop to terminate, and set our latch to wake
@@ -81,12 +153,100 @@ pglogical_ticker_sighup(SIGNAL_ARGS)
 	errno = save_errno;
 }
 
+/*
+ * Current time in microseconds, on the clock instr_time uses, which is
+ * monotonic wherever clock_gettime() is available.  Only differences between
+ * two readings are meaningful.
+ */
+static int64
+ticker_clock_us(void)
+{
+	instr_time	now;
+
+	INSTR_TIME_SET_CURRENT(now);
+
+	return (int64) INSTR_TIME_GET_MICROSEC(now);
+}
+
+/*
+ * Time between two ticks in milliseconds.  pglogical_ticker.naptime_ms
+ * overrides pglogical_ticker.naptime when set.
+ */
+long
+pglogical_ticker_interval_ms(void)
+{
+	if (pglogical_ticker_naptime_ms > 0)
+		return pglogical_ticker_naptime_ms;
+
+	return pglogical_ticker_naptime * 1000L;
+}
+
+/*
+ * Register the named wait events of the worker, where the server has
+ * custom wait events.  The names are shared by all workers: the first one
+ * to ask for a name allocates its wait event.
+ */
+static void
+ticker_wait_events_init(void)
+{
+#if PG_VERSION_NUM >= 170000
+	ticker_wait_events[TICKER_WAIT_NAP] = WaitEventExtensionNew("TickerNap");
+	ticker_wait_events[TICKER_WAIT_CATALOG_REFRESH] =
+		WaitEventExtensionNew("TickerCatalogRefresh");
+	ticker_wait_events[TICKER_WAIT_TICK] = WaitEventExtensionNew("TickerTick");
+	ticker_wait_events[TICKER_WAIT_COMMIT] = WaitEventExtensionNew("TickerCommit");
+#endif
+}
+
+/*
+ * Report that the worker entered a phase of its loop, until the next call or
+ * ticker_report_wait_end().  Real waits within the phase, on a lock or a WAL
+ * flush for instance, replace it with their own wait event, and end it.
+ */
+void
+ticker_report_wait_start(TickerWaitEvent event)
+{
+#if PG_VERSION_NUM >= 170000
+	if (ticker_wait_events[event] != 0)
+		pgstat_report_wait_start(ticker_wait_events[event]);
+#endif
+}
+
+void
+ticker_report_wait_end(void)
+{
+#if PG_VERSION_NUM >= 170000
+	pgstat_report_wait_end();
+#endif
+}
+
+/*
+ * Microseconds since *start, which is then set to now, to time the next
+ * phase from there.
+ */
+static int64
+ticker_phase_lap(instr_time *start)
+{
+	instr_time	now;
+	instr_time	duration;
+
+	INSTR_TIME_SET_CURRENT(now);
+	duration = now;
+	INSTR_TIME_SUBTRACT(duration, *start);
+	*start = now;
+
+	return (int64) INSTR_TIME_GET_MICROSEC(duration);
+}
+
 void
 pglogical_ticker_main(Datum main_arg)
 {
 	Oid db_oid_main = DatumGetObjectId(main_arg);
 
 	StringInfoData buf;
+	bool		supervised;
+	int64		next_sample;
+	int64		next_maintenance;
 
 	/* Establish signal handlers before unblocking signals. */
 	pqsignal(SIGHUP, pglogical_ticker_sighup);
@@ -95,8 +255,13 @@ pglogical_ticker_main(Datum main_arg)
 	/* We're now ready to receive signals */
 	BackgroundWorkerUnblockSignals();
 
-	/* Connect to our database */
-	if (pglogical_ticker_database != NULL)
+	/*
+	 * Connect to our database.  Workers started by launch() or the
+	 * supervisor are given it, and only the one registered at startup goes
+	 * by pglogical_ticker.database, which is still set on servers that
+	 * turned pglogical_ticker.autodiscover on later.
+	 */
+	if (!OidIsValid(db_oid_main) && pglogical_ticker_database != NULL)
 	{
 #if PG_VERSION_NUM >= 110000 
 		BackgroundWorkerInitializeConnection(pglogical_ticker_database, NULL, 0); 
@@ -115,12 +280,51 @@ pglogical_ticker_main(Datum main_arg)
 	SetConfigOption("application_name", MyBgworkerEntry->bgw_name,
 			PGC_USERSET, PGC_S_SESSION);
 
+	supervised = (MyBgworkerEntry->bgw_extra[0] == TICKER_WORKER_SUPERVISED);
+
+	/*
+	 * Make sure we are the only ticker of this database.  A worker started by
+	 * launch() or the supervisor that finds another one running exits with
+	 * code 0, so it is not restarted; the worker configured by
+	 * pglogical_ticker.database keeps trying.
+	 */
+	if (!ticker_worker_attach(MyDatabaseId))
+	{
+		elog(LOG, "%s: another ticker is already running in this database",
+				MyBgworkerEntry->bgw_name);
+		proc_exit(db_oid_main == InvalidOid ? 1 : 0);
+	}
+
+	/*
+	 * The supervisor starts a worker in every database, and only the worker
+	 * can tell whether the extension is installed.
+	 */
+	if (supervised && !pglogical_ticker_installed())
+	{
+		ticker_worker_set_extension_missing();
+		proc_exit(0);
+	}
+	ticker_worker_set_ready();
+
+	ticker_wait_events_init();
+
 	elog(LOG, "%s initialized",
 			MyBgworkerEntry->bgw_name);
 
+	/*
+	 * Activity string reported while ticking.  The ticking itself is done
+	 * natively by pglogical_ticker_tick(), which does what the SQL function
+	 * pglogical_ticker.tick() would do using cached plans.
+	 */
 	initStringInfo(&buf);
 	appendStringInfo(&buf,
-			"SELECT pglogical_ticker.tick();");
+			"pglogical_ticker native tick");
+
+	/* Lag sampling is off until pglogical_ticker.lag_sample_interval_ms is set */
+	next_sample = PG_INT64_MAX;
+
+	/* Lag history maintenance is off until pglogical_ticker.lag_history is on */
+	next_maintenance = PG_INT64_MAX;
 
 	/*
 	 * Main loop: do this until the SIGTERM handler tells us to terminate
@@ -128,38 +332,177 @@ pglogical_ticker_main(Datum main_arg)
 	while (!got_sigterm)
 	{
 		int			rc;
+		int64		now;
+		int64		interval;
+		int64		sample_interval;
+		int64		next_tick;
+		bool		requested;
+		instr_time	tick_start;
+		instr_time	tick_duration;
+		instr_time	phase_start;
+		int64		phase_durations[TICKER_NUM_PHASES];
+		TimestampTz tick_time;
+		TimestampTz commit_time;
+		XLogRecPtr	commit_lsn;
+		bool		wrote;
 
 		/*
-		 * Background workers mustn't call usleep() or any direct equivalent:
-		 * instead, they may wait on their process latch, which sleeps as
-		 * necessary, but is awakened if postmaster dies.  That way the
-		 * background process goes away immediately in an emergency.
+		 * Sleep until the next replication set is due, see
+		 * pglogical_ticker_schedule(), or the next lag sample or lag history
+		 * maintenance is.  tick_now()
+		 * sets our latch, and its requests are ticked right away.
 		 */
+		interval = pglogical_ticker_interval_ms() * 1000L;
+		sample_interval = pglogical_ticker_lag_sample_interval_ms * 1000L;
+		now = ticker_clock_us();
+		next_tick = pglogical_ticker_next_deadline();
+		requested = ticker_worker_tick_requested();
+
+		if (sample_interval <= 0 || !pglogical_ticker_shmem_enabled())
+			next_sample = PG_INT64_MAX;
+		else if (next_sample == PG_INT64_MAX)
+			next_sample = now;
+
+		if (!pglogical_ticker_lag_history)
+			next_maintenance = PG_INT64_MAX;
+		else if (next_maintenance == PG_INT64_MAX)
+			next_maintenance = now;
+
+		if (now < Min(Min(next_tick, next_sample), next_maintenance) && !requested)
+		{
+			/*
+			 * Background workers mustn't call usleep() or any direct equivalent:
+			 * instead, they may wait on their process latch, which sleeps as
+			 * necessary, but is awakened if postmaster dies.  That way the
+			 * background process goes away immediately in an emergency.
+			 */
 #if PG_VERSION_NUM >= 100000 
-		rc = WaitLatch(MyLatch,
-				WL_LATCH_SET | WL_TIMEOUT | WL_POSTMASTER_DEATH,
-				pglogical_ticker_naptime * 1000L,
-				PG_WAIT_EXTENSION);
+			rc = WaitLatch(MyLatch,
+					WL_LATCH_SET | WL_TIMEOUT | WL_POSTMASTER_DEATH,
+					(Min(Min(next_tick, next_sample), next_maintenance) - now + 999) / 1000,
+					ticker_wait_events[TICKER_WAIT_NAP] != 0 ?
+					ticker_wait_events[TICKER_WAIT_NAP] : PG_WAIT_EXTENSION);
 #else
-		rc = WaitLatch(MyLatch,
-				WL_LATCH_SET | WL_TIMEOUT | WL_POSTMASTER_DEATH,
-				pglogical_ticker_naptime * 1000L);
+			rc = WaitLatch(MyLatch,
+					WL_LATCH_SET | WL_TIMEOUT | WL_POSTMASTER_DEATH,
+					(Min(Min(next_tick, next_sample), next_maintenance) - now + 999) / 1000);
 #endif
-		ResetLatch(MyLatch);
+			ResetLatch(MyLatch);
 
-		/* emergency bailout if postmaster has died */
-		if (rc & WL_POSTMASTER_DEATH)
-			proc_exit(1);
+			/* emergency bailout if postmaster has died */
+			if (rc & WL_POSTMASTER_DEATH)
+				proc_exit(1);
 
-		CHECK_FOR_INTERRUPTS();
+			CHECK_FOR_INTERRUPTS();
+
+			/*
+			 * In case of a SIGHUP, just reload the configuration.  A shorter
+			 * interval takes effect for the tick we are waiting for.
+			 */
+			if (got_sighup)
+			{
+				got_sighup = false;
+				ProcessConfigFile(PGC_SIGHUP);
+
+				pglogical_ticker_reschedule(ticker_clock_us(),
+											pglogical_ticker_interval_ms() * 1000L);
+			}
+
+			continue;
+		}
 
 		/*
-		 * In case of a SIGHUP, just reload the configuration.
+		 * The lag history is maintained every hour, in a transaction of its
+		 * own, so that partitions are created and expired ones dropped even
+		 * while no samples are taken.
 		 */
-		if (got_sighup)
+		if (now >= next_maintenance)
 		{
-			got_sighup = false;
-			ProcessConfigFile(PGC_SIGHUP);
+			next_maintenance = now + TICKER_LAG_HISTORY_MAINTENANCE_US;
+
+			SetCurrentStatementStartTimestamp();
+			StartTransactionCommand();
+			PushActiveSnapshot(GetTransactionSnapshot());
+			pgstat_report_activity(STATE_RUNNING, "pglogical_ticker lag history maintenance");
+
+			pglogical_ticker_lag_history_maintenance();
+
+			PopActiveSnapshot();
+			CommitTransactionCommand();
+			pgstat_report_activity(STATE_IDLE, NULL);
+
+			if (now < Min(next_tick, next_sample) && !requested)
+				continue;
+		}
+
+		/*
+		 * Lag samples are taken on a fixed cadence as well, skipping the
+		 * ones we are late for, in a transaction of their own.
+		 */
+		if (now >= next_sample)
+		{
+			next_sample += ((now - next_sample) / sample_interval + 1) * sample_interval;
+
+			SetCurrentStatementStartTimestamp();
+			StartTransactionCommand();
+			PushActiveSnapshot(GetTransactionSnapshot());
+			pgstat_report_activity(STATE_RUNNING, "pglogical_ticker lag sample");
+
+			pglogical_ticker_sample_lag();
+
+			PopActiveSnapshot();
+			CommitTransactionCommand();
+			pgstat_report_activity(STATE_IDLE, NULL);
+
+			if (now < next_tick && !requested)
+				continue;
+		}
+
+		pglogical_ticker_schedule(now, interval);
+
+		/*
+		 * With pglogical_ticker.auto_provision, new replication sets get
+		 * their ticker tables in a transaction of their own, so that the tick
+		 * does not wait on the locks of that DDL, nor fail with it.
+		 */
+		if (pglogical_ticker_provision_due(now))
+		{
+			SetCurrentStatementStartTimestamp();
+			StartTransactionCommand();
+			SPI_connect();
+			PushActiveSnapshot(GetTransactionSnapshot());
+			pgstat_report_activity(STATE_RUNNING, "pglogical_ticker provision");
+
+			pglogical_ticker_provision(now);
+
+			SPI_finish();
+			PopActiveSnapshot();
+			CommitTransactionCommand();
+			pgstat_report_activity(STATE_IDLE, NULL);
+		}
+
+		/*
+		 * When no set is due, as when the only deadline reached is the one of
+		 * the default interval and no set uses it, only look for new ticker
+		 * tables.  That transaction writes nothing, and is not a tick.
+		 */
+		if (!requested && !pglogical_ticker_tick_due())
+		{
+			SetCurrentStatementStartTimestamp();
+			StartTransactionCommand();
+			SPI_connect();
+			PushActiveSnapshot(GetTransactionSnapshot());
+			pgstat_report_activity(STATE_RUNNING, "pglogical_ticker refresh");
+
+			pglogical_ticker_refresh();
+
+			SPI_finish();
+			PopActiveSnapshot();
+			CommitTransactionCommand();
+			pgstat_report_activity(STATE_IDLE, NULL);
+
+			if (!pglogical_ticker_tick_due())
+				continue;
 		}
 
 		/*
@@ -178,28 +521,345 @@ pglogical_ticker_main(Datum main_arg)
 		 * The pgstat_report_activity() call makes our activity visible
 		 * through the pgstat views.
 		 */
-		SetCurrentStatementStartTimestamp();
-		StartTransactionCommand();
-		SPI_connect();
-		PushActiveSnapshot(GetTransactionSnapshot());
-		pgstat_report_activity(STATE_RUNNING, buf.data);
-
-		/* We can now execute queries via SPI */
-		SPI_execute(buf.data, false, 0);
+		INSTR_TIME_SET_CURRENT(tick_start);
 
 		/*
-		 * And finish our transaction.
+		 * Errors still terminate the worker, but are counted in the shared
+		 * memory registry first, so that repeated failures across worker
+		 * restarts are visible in pglogical_ticker.worker_status().
 		 */
-		SPI_finish();
-		PopActiveSnapshot();
-		CommitTransactionCommand();
+		phase_start = tick_start;
+		PG_TRY();
+		{
+			SetCurrentStatementStartTimestamp();
+			StartTransactionCommand();
+			phase_durations[TICKER_PHASE_START_TRANSACTION] =
+				ticker_phase_lap(&phase_start);
+			SPI_connect();
+			phase_durations[TICKER_PHASE_SPI_CONNECT] = ticker_phase_lap(&phase_start);
+			PushActiveSnapshot(GetTransactionSnapshot());
+			pgstat_report_activity(STATE_RUNNING, buf.data);
+			tick_time = GetCurrentTransactionStartTimestamp();
+
+			/* We can now execute queries via SPI */
+			pglogical_ticker_tick();
+			phase_durations[TICKER_PHASE_EXECUTE] = ticker_phase_lap(&phase_start);
+
+			/*
+			 * And finish our transaction.  Its commit waits for the WAL flush,
+			 * and for synchronous standbys if any, so timing it on its own
+			 * tells how slow the write path of this node currently is.
+			 */
+			SPI_finish();
+			PopActiveSnapshot();
+
+			/*
+			 * A tick which wrote nothing, having no ticker table to write to,
+			 * has no xid and its commit writes no record, so it has no commit
+			 * LSN or time of its own.
+			 */
+			wrote = TransactionIdIsValid(GetTopTransactionIdIfAny());
+			ticker_report_wait_start(TICKER_WAIT_COMMIT);
+			CommitTransactionCommand();
+			ticker_report_wait_end();
+			phase_durations[TICKER_PHASE_COMMIT] = ticker_phase_lap(&phase_start);
+
+			/* The timestamp written to the commit record, and to its commit ts */
+			commit_time = wrote ? GetCurrentTransactionStopTimestamp() : 0;
+			commit_lsn = wrote ? XactLastCommitEnd : InvalidXLogRecPtr;
+		}
+		PG_CATCH();
+		{
+			pglogical_ticker_tick_failed();
+			PG_RE_THROW();
+		}
+		PG_END_TRY();
+
+		INSTR_TIME_SET_CURRENT(tick_duration);
+		INSTR_TIME_SUBTRACT(tick_duration, tick_start);
+		pglogical_ticker_tick_done(tick_time, commit_time,
+								   (int64) INSTR_TIME_GET_MICROSEC(tick_duration),
+								   commit_lsn);
+
+		INSTR_TIME_SET_CURRENT(phase_start);
 		pgstat_report_stat(false);
+		phase_durations[TICKER_PHASE_REPORT_STAT] = ticker_phase_lap(&phase_start);
+		ticker_worker_count_phases(phase_durations);
 		pgstat_report_activity(STATE_IDLE, NULL);
 	}
 	
 	proc_exit(1);
 }
 
+/*
+ * Is the extension installed in the database we are connected to?
+ */
+static bool
+pglogical_ticker_installed(void)
+{
+	bool		installed;
+
+	SetCurrentStatementStartTimestamp();
+	StartTransactionCommand();
+	installed = OidIsValid(get_extension_oid("pglogical_ticker", true));
+	CommitTransactionCommand();
+
+	return installed;
+}
+
+/*
+ * Start a ticker worker for a database on behalf of the supervisor.
+ */
+static BackgroundWorkerHandle *
+pglogical_ticker_supervisor_start(Oid dbid)
+{
+	BackgroundWorker worker;
+	BackgroundWorkerHandle *handle;
+
+	memset(&worker, 0, sizeof(worker));
+	worker.bgw_flags = BGWORKER_SHMEM_ACCESS |
+		BGWORKER_BACKEND_DATABASE_CONNECTION;
+	worker.bgw_start_time = BgWorkerStart_RecoveryFinished;
+	/* the supervisor does the restarting */
+	worker.bgw_restart_time = BGW_NEVER_RESTART;
+	sprintf(worker.bgw_library_name, "pglogical_ticker");
+	sprintf(worker.bgw_function_name, "pglogical_ticker_main");
+	snprintf(worker.bgw_name, BGW_MAXLEN, "pglogical_ticker worker");
+#if PG_VERSION_NUM >= 110000 
+	snprintf(worker.bgw_type, BGW_MAXLEN, "pglogical_ticker");
+#endif
+	worker.bgw_main_arg = ObjectIdGetDatum(dbid);
+	worker.bgw_extra[0] = TICKER_WORKER_SUPERVISED;
+	/* get notified of state changes, which sets our latch */
+	worker.bgw_notify_pid = MyProcPid;
+
+	if (!RegisterDynamicBackgroundWorker(&worker, &handle))
+	{
+		elog(WARNING, "pglogical_ticker supervisor: could not start ticker for database %u",
+				dbid);
+		return NULL;
+	}
+
+	return handle;
+}
+
+/*
+ * Look at every database, and start a ticker in those which do not have a
+ * running one.  A stopped ticker is restarted after
+ * pglogical_ticker.restart_time, or after TICKER_SUPERVISOR_RECHECK_MS, and
+ * then less and less often, if it found that the extension is not installed.
+ * Databases in which another ticker runs, such as one started by launch(),
+ * are left alone.  At most TICKER_SUPERVISOR_MAX_PROBES workers are started
+ * or running in databases not known to have the extension; the others wait
+ * for the next scan.
+ */
+static void
+pglogical_ticker_supervisor_scan(TickerDbWorker **dbs, int *ndbs, int *maxdbs)
+{
+	Relation	rel;
+	TableScanDesc scan;
+	HeapTuple	tup;
+	TimestampTz now;
+	int			nprobes = 0;
+	int			i;
+
+	for (i = 0; i < *ndbs; i++)
+		(*dbs)[i].seen = false;
+
+	SetCurrentStatementStartTimestamp();
+	StartTransactionCommand();
+	(void) GetTransactionSnapshot();
+
+	rel = table_open(DatabaseRelationId, AccessShareLock);
+	scan = table_beginscan_catalog(rel, 0, NULL);
+
+	while ((tup = heap_getnext(scan, ForwardScanDirection)) != NULL)
+	{
+		Form_pg_database pgdatabase = (Form_pg_database) GETSTRUCT(tup);
+		Oid			dbid = TickerDatabaseTupleGetOid(tup);
+
+		if (!pgdatabase->datallowconn || pgdatabase->datistemplate)
+			continue;
+
+		for (i = 0; i < *ndbs; i++)
+		{
+			if ((*dbs)[i].dbid == dbid)
+				break;
+		}
+		if (i == *ndbs)
+		{
+			if (*ndbs == *maxdbs)
+			{
+				*maxdbs *= 2;
+				*dbs = repalloc(*dbs, sizeof(TickerDbWorker) * (*maxdbs));
+			}
+			memset(&(*dbs)[i], 0, sizeof(TickerDbWorker));
+			(*dbs)[i].dbid = dbid;
+			(*ndbs)++;
+		}
+		(*dbs)[i].seen = true;
+	}
+
+	table_endscan(scan);
+	table_close(rel, AccessShareLock);
+
+	CommitTransactionCommand();
+
+	now = GetCurrentTimestamp();
+
+	/* Drop the handles of stopped workers, and count the probes in flight */
+	for (i = 0; i < *ndbs; i++)
+	{
+		TickerDbWorker *db = &(*dbs)[i];
+		BgwHandleStatus status;
+		pid_t		pid;
+
+		if (db->handle == NULL)
+			continue;
+
+		status = GetBackgroundWorkerPid(db->handle, &pid);
+		if (status == BGWH_POSTMASTER_DIED)
+			proc_exit(1);
+		if (status == BGWH_STARTED || status == BGWH_NOT_YET_STARTED)
+		{
+			if (ticker_worker_db_state(db->dbid) == TICKER_DB_UNKNOWN)
+				nprobes++;
+			continue;
+		}
+
+		pfree(db->handle);
+		db->handle = NULL;
+	}
+
+	for (i = 0; i < *ndbs; i++)
+	{
+		TickerDbWorker *db = &(*dbs)[i];
+		TickerDbState state;
+		int			delay_ms;
+
+		if (db->handle != NULL || !db->seen)
+			continue;
+
+		state = ticker_worker_db_state(db->dbid);
+		if (state == TICKER_DB_RUNNING)
+		{
+			/* not ours, or it would have a handle */
+			db->last_start = now;
+			db->rechecks = 0;
+			continue;
+		}
+
+		if (db->last_start != 0)
+		{
+			if (state == TICKER_DB_MISSING)
+				delay_ms = TICKER_SUPERVISOR_RECHECK_MS <<
+					Min(db->rechecks, TICKER_SUPERVISOR_MAX_RECHECKS);
+			else if (state == TICKER_DB_STOPPED && pglogical_ticker_restart_time < 0)
+				continue;
+			else
+				delay_ms = Max(pglogical_ticker_restart_time, 0) * 1000;
+
+			if (!TimestampDifferenceExceeds(db->last_start, now, delay_ms))
+				continue;
+		}
+
+		if (state != TICKER_DB_STOPPED)
+		{
+			if (nprobes >= TICKER_SUPERVISOR_MAX_PROBES)
+				continue;
+			nprobes++;
+		}
+
+		if (state == TICKER_DB_MISSING)
+			db->rechecks++;
+		else
+			db->rechecks = 0;
+
+		db->handle = pglogical_ticker_supervisor_start(db->dbid);
+		db->last_start = now;
+	}
+
+	/* Forget databases which are gone and have no worker left */
+	for (i = 0; i < *ndbs;)
+	{
+		if (!(*dbs)[i].seen && (*dbs)[i].handle == NULL)
+		{
+			(*dbs)[i] = (*dbs)[*ndbs - 1];
+			(*ndbs)--;
+		}
+		else
+			i++;
+	}
+}
+
+/*
+ * Supervisor: keeps a ticker running in every database that has the
+ * extension installed.  Only used with pglogical_ticker.autodiscover.
+ */
+void
+pglogical_ticker_supervisor_main(Datum main_arg)
+{
+	TickerDbWorker *dbs;
+	int			ndbs = 0;
+	int			maxdbs = 16;
+
+	/* Establish signal handlers before unblocking signals. */
+	pqsignal(SIGHUP, pglogical_ticker_sighup);
+	pqsignal(SIGTERM, pglogical_ticker_sigterm);
+
+	/* We're now ready to receive signals */
+	BackgroundWorkerUnblockSignals();
+
+	/* Only connect to shared catalogs, we only ever read pg_database */
+#if PG_VERSION_NUM >= 110000 
+	BackgroundWorkerInitializeConnection(NULL, NULL, 0);
+#else
+	BackgroundWorkerInitializeConnection(NULL, NULL);
+#endif
+	SetConfigOption("application_name", MyBgworkerEntry->bgw_name,
+			PGC_USERSET, PGC_S_SESSION);
+
+	ticker_wait_events_init();
+
+	elog(LOG, "%s initialized",
+			MyBgworkerEntry->bgw_name);
+
+	dbs = MemoryContextAllocZero(TopMemoryContext, sizeof(TickerDbWorker) * maxdbs);
+
+	while (!got_sigterm)
+	{
+		int			rc;
+
+		pglogical_ticker_supervisor_scan(&dbs, &ndbs, &maxdbs);
+
+#if PG_VERSION_NUM >= 100000 
+		rc = WaitLatch(MyLatch,
+				WL_LATCH_SET | WL_TIMEOUT | WL_POSTMASTER_DEATH,
+				TICKER_SUPERVISOR_NAPTIME_MS,
+				PG_WAIT_EXTENSION);
+#else
+		rc = WaitLatch(MyLatch,
+				WL_LATCH_SET | WL_TIMEOUT | WL_POSTMASTER_DEATH,
+				TICKER_SUPERVISOR_NAPTIME_MS);
+#endif
+		ResetLatch(MyLatch);
+
+		/* emergency bailout if postmaster has died */
+		if (rc & WL_POSTMASTER_DEATH)
+			proc_exit(1);
+
+		CHECK_FOR_INTERRUPTS();
+
+		if (got_sighup)
+		{
+			got_sighup = false;
+			ProcessConfigFile(PGC_SIGHUP);
+		}
+	}
+
+	proc_exit(1);
+}
+
 /*
  * Entrypoint of this module.
  *
@@ -227,6 +887,19 @@ _PG_init(void)
 			NULL);
 
 
+	DefineCustomIntVariable("pglogical_ticker.naptime_ms",
+			"Duration between each tick (in milliseconds). Overrides pglogical_ticker.naptime unless 0.",
+			NULL,
+			&pglogical_ticker_naptime_ms,
+			pglogical_ticker_naptime_ms,
+			0,
+			INT_MAX,
+			PGC_SIGHUP,
+			GUC_UNIT_MS,
+			NULL,
+			NULL,
+			NULL);
+
 	DefineCustomStringVariable("pglogical_ticker.database",
 			"Database to connect to.",
 			NULL,
@@ -251,12 +924,156 @@ _PG_init(void)
 			NULL,
 			NULL);
 
+	DefineCustomBoolVariable("pglogical_ticker.batch_tick",
+			"Tick all replication sets with a single statement.",
+			NULL,
+			&pglogical_ticker_batch_tick,
+			pglogical_ticker_batch_tick,
+			PGC_SIGHUP,
+			0,
+			NULL,
+			NULL,
+			NULL);
+
+	DefineCustomIntVariable("pglogical_ticker.max_tracked_sets",
+			"Number of replication sets whose tick status is kept in shared memory.",
+			NULL,
+			&pglogical_ticker_max_tracked_sets,
+			pglogical_ticker_max_tracked_sets,
+			1,
+			INT_MAX / 2,
+			PGC_POSTMASTER,
+			0,
+			NULL,
+			NULL,
+			NULL);
+
+	DefineCustomIntVariable("pglogical_ticker.apply_ring_size",
+			"Number of applied ticks kept in shared memory by the apply trigger.",
+			NULL,
+			&pglogical_ticker_apply_ring_size,
+			pglogical_ticker_apply_ring_size,
+			16,
+			1048576,
+			PGC_POSTMASTER,
+			0,
+			NULL,
+			NULL,
+			NULL);
+
+	DefineCustomIntVariable("pglogical_ticker.lag_sample_interval_ms",
+			"How often to sample the lag of subscribed replication sets into histograms. 0 to disable.",
+			NULL,
+			&pglogical_ticker_lag_sample_interval_ms,
+			pglogical_ticker_lag_sample_interval_ms,
+			0,
+			INT_MAX,
+			PGC_SIGHUP,
+			GUC_UNIT_MS,
+			NULL,
+			NULL,
+			NULL);
+
+	DefineCustomBoolVariable("pglogical_ticker.auto_provision",
+			"Deploy and add to replication the ticker tables of new replication sets.",
+			"Only meant for providers: subscribers get the tables through the replicated DDL.",
+			&pglogical_ticker_auto_provision,
+			pglogical_ticker_auto_provision,
+			PGC_SIGHUP,
+			0,
+			NULL,
+			NULL,
+			NULL);
+
+	DefineCustomBoolVariable("pglogical_ticker.lag_history",
+			"Keep the lag samples in pglogical_ticker.lag_history.",
+			NULL,
+			&pglogical_ticker_lag_history,
+			pglogical_ticker_lag_history,
+			PGC_SIGHUP,
+			0,
+			NULL,
+			NULL,
+			NULL);
+
+	/* These two are only read by pglogical_ticker.lag_history_maintenance() */
+	DefineCustomIntVariable("pglogical_ticker.lag_history_retention_days",
+			"Number of days raw lag samples are kept in pglogical_ticker.lag_history.",
+			NULL,
+			&pglogical_ticker_lag_history_retention_days,
+			pglogical_ticker_lag_history_retention_days,
+			1,
+			36500,
+			PGC_SIGHUP,
+			0,
+			NULL,
+			NULL,
+			NULL);
+
+	DefineCustomIntVariable("pglogical_ticker.lag_history_rollup_retention_days",
+			"Number of days 1 minute lag aggregates are kept in pglogical_ticker.lag_history_1m.",
+			NULL,
+			&pglogical_ticker_lag_history_rollup_retention_days,
+			pglogical_ticker_lag_history_rollup_retention_days,
+			1,
+			36500,
+			PGC_SIGHUP,
+			0,
+			NULL,
+			NULL,
+			NULL);
+
+	DefineCustomBoolVariable("pglogical_ticker.use_commit_timestamp",
+			"Measure lag from the commit time of ticks rather than their start time.",
+			"Needs track_commit_timestamp, on the subscriber for lag readings.",
+			&pglogical_ticker_use_commit_timestamp,
+			pglogical_ticker_use_commit_timestamp,
+			PGC_USERSET,
+			0,
+			NULL,
+			NULL,
+			NULL);
+
+	DefineCustomBoolVariable("pglogical_ticker.autodiscover",
+			"Run a ticker in every database that has the extension installed.",
+			NULL,
+			&pglogical_ticker_autodiscover,
+			pglogical_ticker_autodiscover,
+			PGC_POSTMASTER,
+			0,
+			NULL,
+			NULL,
+			NULL);
+
 	if (!process_shared_preload_libraries_in_progress)
 		return;
 
+	pglogical_ticker_shmem_init();
+
+	/*
+	 * With autodiscover, the supervisor starts the tickers of all databases,
+	 * including the one in pglogical_ticker.database, which is otherwise
+	 * ignored.
+	 */
+	if (pglogical_ticker_autodiscover)
+	{
+		memset(&worker, 0, sizeof(worker));
+		worker.bgw_flags = BGWORKER_SHMEM_ACCESS |
+			BGWORKER_BACKEND_DATABASE_CONNECTION;
+		worker.bgw_start_time = BgWorkerStart_RecoveryFinished;
+		worker.bgw_restart_time = pglogical_ticker_restart_time;
+		sprintf(worker.bgw_library_name, "pglogical_ticker");
+		sprintf(worker.bgw_function_name, "pglogical_ticker_supervisor_main");
+		snprintf(worker.bgw_name, BGW_MAXLEN, "pglogical_ticker supervisor");
+#if PG_VERSION_NUM >= 110000 
+		snprintf(worker.bgw_type, BGW_MAXLEN, "pglogical_ticker");
+#endif
+		worker.bgw_notify_pid = 0;
 
+		RegisterBackgroundWorker(&worker);
+	}
 	/* Only auto-start worker if pglogical_ticker_database is set */
-	if (pglogical_ticker_database)
+	else if (pglogical_ticker_database)
 	{
 		/* set up common data for all our workers */
 		memset(&worker, 0, sizeof(worker));
@@ -332,3 +1149,43 @@ pglogical_ticker_launch(PG_FUNCTION_ARGS)
 	PG_RETURN_INT32(pid);
 }
 
+/*
+ * Set up a set-returning function to return its result in materialize mode,
+ * the way all our SRFs do.  Returns the tuplestore to fill, and the result
+ * tuple descriptor in *tupdesc.
+ */
+Tuplestorestate *
+ticker_materialized_srf(FunctionCallInfo fcinfo, TupleDesc *tupdesc)
+{
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	MemoryContext per_query_ctx;
+	MemoryContext oldcontext;
+	Tuplestorestate *tupstore;
+
+	/* check to see if caller supports us returning a tuplestore */
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("set-valued function called in context that cannot accept a set")));
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("materialize mode required, but it is not allowed in this context")));
+
+	/* Build a tuple descriptor for our result type */
+	if (get_call_result_type(fcinfo, NULL, tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	*tupdesc = CreateTupleDescCopy(*tupdesc);
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = *tupdesc;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	return tupstore;
+}
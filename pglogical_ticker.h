@@ -0,0 +1,222 @@
+/* -------------------------------------------------------------------------
+ *
+ * pglogical_ticker.h
+ *		Declarations shared between the pglogical_ticker source files.
+ *
+ * -------------------------------------------------------------------------
+ */
+#ifndef PGLOGICAL_TICKER_H
+#define PGLOGICAL_TICKER_H
+
+#include "fmgr.h"
+#include "access/tupdesc.h"
+#include "access/xlogdefs.h"
+#include "executor/spi.h"
+#include "datatype/timestamp.h"
+#include "storage/latch.h"
+#include "utils/tuplestore.h"
+
+#if PG_VERSION_NUM >= 120000
+#include "access/table.h"
+#include "access/tableam.h"
+#else
+#include "access/heapam.h"
+#define table_open(relid, lockmode) heap_open(relid, lockmode)
+#define table_close(rel, lockmode) heap_close(rel, lockmode)
+#define table_beginscan(rel, snapshot, nkeys, keys) \
+	heap_beginscan(rel, snapshot, nkeys, keys)
+#define table_beginscan_catalog(rel, nkeys, keys) \
+	heap_beginscan_catalog(rel, nkeys, keys)
+#define table_endscan(scan) heap_endscan(scan)
+typedef HeapScanDesc TableScanDesc;
+#endif
+
+/* Columns of a ticker table, as created by deploy_ticker_tables() */
+#define Anum_ticker_provider_name	1
+#define Anum_ticker_source_time		2
+
+/*
+ * Shared memory status of one replication set ticked by a worker,
+ * see pglogical_ticker_shmem.c.
+ */
+typedef struct TickerSetStatusKey
+{
+	Oid			dbid;
+	NameData	set_name;
+} TickerSetStatusKey;
+
+typedef struct TickerSetStatus
+{
+	TickerSetStatusKey key;
+	int			worker_pid;
+	TimestampTz last_tick_time; /* 0 if never ticked */
+	int64		last_tick_duration; /* microseconds */
+	XLogRecPtr	last_commit_lsn;
+	int64		consecutive_errors;
+	int64		tick_interval;	/* microseconds, as of its last tick */
+	bool		tick_requested; /* by tick_now(), not yet ticked */
+} TickerSetStatus;
+
+/*
+ * Tick durations are counted in buckets bounded by 1 ms to 10 s, and a last
+ * bucket for slower ticks, see ticker_tick_duration_bounds.
+ */
+#define TICKER_TICK_DURATION_BUCKETS	14
+
+/*
+ * Phases of a tick timed by the worker, see pglogical_ticker.tick_phase_stats().
+ */
+typedef enum TickerPhase
+{
+	TICKER_PHASE_START_TRANSACTION,
+	TICKER_PHASE_SPI_CONNECT,
+	TICKER_PHASE_EXECUTE,
+	TICKER_PHASE_COMMIT,
+	TICKER_PHASE_REPORT_STAT,
+	TICKER_NUM_PHASES
+} TickerPhase;
+
+typedef struct TickerPhaseStats
+{
+	int64		calls;
+	int64		total;			/* microseconds */
+	int64		max;			/* microseconds */
+	int64		last;			/* microseconds */
+	double		recent;			/* moving average, microseconds */
+} TickerPhaseStats;
+
+/*
+ * Time and commit LSN of a tick.  Each worker keeps its last
+ * TICKER_COMMIT_HISTORY ticks, see pglogical_ticker.tick_commits().
+ */
+#define TICKER_COMMIT_HISTORY	64
+
+typedef struct TickerCommit
+{
+	TimestampTz tick_time;
+	XLogRecPtr	commit_lsn;
+} TickerCommit;
+
+/*
+ * Shared memory status of a ticker worker, one per database.
+ */
+typedef struct TickerWorkerStatus
+{
+	Oid			dbid;			/* InvalidOid if the slot is unused */
+	int			pid;			/* 0 if the worker is not running */
+	Latch	   *latch;			/* of the running worker, or NULL */
+	int64		interval;		/* current tick interval, microseconds */
+	int64		ticks;			/* ticks fired by the scheduler */
+	int64		late_ticks;		/* ticks fired late */
+	int64		missed_ticks;	/* deadlines skipped altogether */
+	int64		tick_errors;	/* ticks that failed */
+	int64		starts;			/* workers started for this database */
+	int64		tick_duration_sum;	/* microseconds, over successful ticks */
+	int64		tick_durations[TICKER_TICK_DURATION_BUCKETS];
+	TickerPhaseStats phases[TICKER_NUM_PHASES];
+	int64		ncommits;		/* ticks ever added to commits[] */
+	TickerCommit commits[TICKER_COMMIT_HISTORY];	/* ring */
+	int64		tick_requests;	/* tick_now() requests made */
+	int64		tick_requests_served;	/* requests served by a committed tick */
+	TimestampTz served_tick_time;	/* source_time of the tick which served
+									 * them */
+	TimestampTz served_commit_time; /* its commit record timestamp */
+	XLogRecPtr	served_commit_lsn;	/* its commit LSN */
+	bool		extension_missing;	/* database lacks the extension */
+	bool		ready;			/* last worker got past its start-up checks */
+} TickerWorkerStatus;
+
+/*
+ * What the supervisor knows of a database, from its worker slot.
+ */
+typedef enum TickerDbState
+{
+	TICKER_DB_UNKNOWN,			/* never looked at, or being looked at */
+	TICKER_DB_MISSING,			/* the extension is not installed */
+	TICKER_DB_RUNNING,			/* a ticker is running */
+	TICKER_DB_STOPPED			/* its ticker is gone */
+} TickerDbState;
+
+/*
+ * Wait events the worker reports around the phases of its loop.  They are
+ * named from PostgreSQL 17 on; before that, the nap is reported as the
+ * generic Extension wait event and the other phases are not reported.
+ */
+typedef enum TickerWaitEvent
+{
+	TICKER_WAIT_NAP,			/* TickerNap: sleeping until the next tick */
+	TICKER_WAIT_CATALOG_REFRESH,	/* TickerCatalogRefresh: re-reading the sets */
+	TICKER_WAIT_TICK,			/* TickerTick: inserting the ticks */
+	TICKER_WAIT_COMMIT,			/* TickerCommit: committing the tick */
+	TICKER_NUM_WAIT_EVENTS
+} TickerWaitEvent;
+
+/* GUC variables, defined in pglogical_ticker.c */
+extern bool pglogical_ticker_batch_tick;
+extern bool pglogical_ticker_lag_history;
+extern bool pglogical_ticker_use_commit_timestamp;
+extern bool pglogical_ticker_auto_provision;
+
+/* GUC variables, defined in pglogical_ticker_shmem.c */
+extern int	pglogical_ticker_max_tracked_sets;
+extern int	pglogical_ticker_apply_ring_size;
+
+/* pglogical_ticker.c */
+extern long pglogical_ticker_interval_ms(void);
+extern void ticker_report_wait_start(TickerWaitEvent event);
+extern void ticker_report_wait_end(void);
+extern Tuplestorestate *ticker_materialized_srf(FunctionCallInfo fcinfo,
+												TupleDesc *tupdesc);
+
+/* pglogical_ticker_tick.c */
+extern int64 pglogical_ticker_next_deadline(void);
+extern void pglogical_ticker_schedule(int64 now, int64 interval);
+extern void pglogical_ticker_reschedule(int64 now, int64 interval);
+extern bool pglogical_ticker_provision_due(int64 now);
+extern void pglogical_ticker_provision(int64 now);
+extern bool pglogical_ticker_tick_due(void);
+extern void pglogical_ticker_refresh(void);
+extern void pglogical_ticker_tick(void);
+extern void pglogical_ticker_tick_done(TimestampTz tick_time,
+									   TimestampTz commit_time, int64 duration,
+									   XLogRecPtr commit_lsn);
+extern void pglogical_ticker_tick_failed(void);
+extern SPIPlanPtr ticker_prepare_kept(const char *query, int nargs,
+									  Oid *argtypes);
+
+/* pglogical_ticker_lag.c */
+extern void pglogical_ticker_sample_lag(void);
+extern void pglogical_ticker_lag_history_maintenance(void);
+extern NameData *ticker_repset_names(int *nsets);
+
+/* pglogical_ticker_shmem.c */
+extern void pglogical_ticker_shmem_init(void);
+extern bool pglogical_ticker_shmem_enabled(void);
+extern bool ticker_worker_attach(Oid dbid);
+extern void ticker_worker_set_extension_missing(void);
+extern void ticker_worker_set_ready(void);
+extern TickerDbState ticker_worker_db_state(Oid dbid);
+extern void ticker_worker_count_tick(int64 interval, bool late, int64 missed);
+extern void ticker_worker_count_tick_done(TimestampTz tick_time, int64 duration,
+										  XLogRecPtr commit_lsn);
+extern void ticker_worker_count_tick_error(void);
+extern void ticker_worker_count_phases(int64 *durations);
+extern bool ticker_worker_tick_requested(void);
+extern int64 ticker_worker_take_tick_requests(TickerSetStatus **entries,
+											  int nentries, bool *requested);
+extern void ticker_worker_serve_tick_requests(int64 served, TimestampTz tick_time,
+											  TimestampTz commit_time,
+											  XLogRecPtr commit_lsn);
+extern TickerSetStatus *ticker_status_enter(Oid dbid, const char *set_name);
+extern void ticker_status_prune(Oid dbid, TickerSetStatus **keep, int nkeep);
+extern void ticker_status_report(TickerSetStatus **entries, int64 *intervals,
+								 int nentries,
+								 TimestampTz tick_time, int64 duration,
+								 XLogRecPtr commit_lsn);
+extern void ticker_status_report_error(TickerSetStatus **entries, int nentries);
+extern void ticker_lag_record(Oid dbid, Name provider_name, Name set_name,
+							  int64 lag);
+extern void ticker_apply_record(Oid dbid, Name provider_name, Name set_name,
+								TimestampTz source_time, TimestampTz apply_time);
+
+#endif							/* PGLOGICAL_TICKER_H */
@@ -0,0 +1,824 @@
+/* -------------------------------------------------------------------------
+ *
+ * pglogical_ticker_lag.c
+ *		Subscriber-side replication lag from the ticker tables.
+ *
+ * pglogical_ticker.lag() does what a query over all_subscription_tickers()
+ * would do, but looks up the ticker tables of the subscribed replication
+ * sets by name and scans them directly, instead of building and running a
+ * dynamic UNION ALL query over pg_stat_user_tables.  It is meant to be cheap
+ * enough to be polled every second, e.g. by a load balancer.
+ *
+ * all_repset_tickers() and all_subscription_tickers() scan the ticker tables
+ * the same way, instead of the UNION ALL queries they used to build over
+ * pg_stat_user_tables.
+ *
+ * The worker uses the same scan to sample the lag into the histograms of
+ * pglogical_ticker_shmem.c.
+ *
+ * With pglogical_ticker.lag_history on, the worker also keeps the samples
+ * and writes them to pglogical_ticker.lag_history in batches.  The worker
+ * runs the maintenance of the history every hour, on a schedule of its own.
+ *
+ * The apply trigger of the ticker tables measures the lag as ticks arrive
+ * instead, logging them into the ring buffer of pglogical_ticker_shmem.c.
+ *
+ * source_time is when the tick transaction started on the provider.  With
+ * pglogical_ticker.use_commit_timestamp, all of the above take the commit
+ * time of the tick instead, which pglogical preserves on subscribers, so
+ * that the time the tick transaction took is not counted as lag.
+ *
+ * -------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "funcapi.h"
+#include "miscadmin.h"
+#include "access/commit_ts.h"
+#include "access/htup_details.h"
+#include "access/xact.h"
+#if PG_VERSION_NUM >= 120000
+#include "access/relation.h"
+#endif
+#include "catalog/namespace.h"
+#include "catalog/pg_type.h"
+#include "commands/trigger.h"
+#include "executor/spi.h"
+#include "replication/origin.h"
+#include "utils/acl.h"
+#include "utils/array.h"
+#include "utils/builtins.h"
+#include "utils/lsyscache.h"
+#include "utils/rel.h"
+#include "utils/snapmgr.h"
+#include "utils/timestamp.h"
+
+#include "pglogical_ticker.h"
+
+/* Columns of pglogical_ticker.set_config */
+#define Anum_set_config_set_name		1
+#define Anum_set_config_tick_interval	2
+
+typedef struct TickerSetInterval
+{
+	NameData	set_name;
+	int64		interval;		/* microseconds */
+} TickerSetInterval;
+
+/* A lag sample waiting to be written to pglogical_ticker.lag_history */
+typedef struct TickerLagSample
+{
+	TimestampTz sample_time;
+	NameData	provider_name;
+	NameData	set_name;
+	int64		lag;			/* microseconds */
+} TickerLagSample;
+
+/* Write samples once that many are buffered, or the oldest is that old */
+#define TICKER_LAG_HISTORY_BATCH		1000
+#define TICKER_LAG_HISTORY_FLUSH_US		(10 * USECS_PER_SEC)
+
+static TickerLagSample *ticker_lag_samples = NULL;
+static int	ticker_nlag_samples = 0;
+static int	ticker_maxlag_samples = 0;
+static SPIPlanPtr ticker_lag_history_plan = NULL;
+
+PG_FUNCTION_INFO_V1(pglogical_ticker_lag);
+PG_FUNCTION_INFO_V1(pglogical_ticker_all_repset_tickers);
+PG_FUNCTION_INFO_V1(pglogical_ticker_all_subscription_tickers);
+PG_FUNCTION_INFO_V1(pglogical_ticker_apply_trigger);
+
+/*
+ * Open a relation of another schema for reading, checking that the user may
+ * read it, since we scan it directly.  Returns NULL if it does not exist.
+ */
+static Relation
+ticker_open_readable(const char *nspname, const char *relname)
+{
+	Oid			nspid;
+	Oid			relid;
+	Relation	rel;
+
+	nspid = get_namespace_oid(nspname, true);
+	if (!OidIsValid(nspid))
+		return NULL;
+
+	relid = get_relname_relid(relname, nspid);
+	if (!OidIsValid(relid))
+		return NULL;
+
+	if (pg_class_aclcheck(relid, GetUserId(), ACL_SELECT) != ACLCHECK_OK)
+		ereport(ERROR,
+				(errcode(ERRCODE_INSUFFICIENT_PRIVILEGE),
+				 errmsg("permission denied for table %s.%s",
+						nspname, relname)));
+
+	/* The table may have been dropped in the meantime */
+	rel = try_relation_open(relid, AccessShareLock);
+	if (rel != NULL && rel->rd_rel->relkind != RELKIND_RELATION)
+	{
+		relation_close(rel, AccessShareLock);
+		return NULL;
+	}
+
+	return rel;
+}
+
+static int
+ticker_name_cmp(const void *a, const void *b)
+{
+	return strcmp(NameStr(*(const NameData *) a), NameStr(*(const NameData *) b));
+}
+
+/*
+ * Sort the names and remove duplicates, returning how many are left.
+ */
+static int
+ticker_sort_names(NameData *names, int nnames)
+{
+	int			i;
+	int			j;
+
+	qsort(names, nnames, sizeof(NameData), ticker_name_cmp);
+	for (i = 0, j = 0; i < nnames; i++)
+	{
+		if (j == 0 || ticker_name_cmp(&names[i], &names[j - 1]) != 0)
+			names[j++] = names[i];
+	}
+
+	return j;
+}
+
+/*
+ * Distinct names of the replication sets of this node, sorted.
+ */
+NameData *
+ticker_repset_names(int *nsets)
+{
+	Relation	rel;
+	TableScanDesc scan;
+	HeapTuple	tup;
+	AttrNumber	attnum;
+	NameData   *sets;
+	int			maxsets = 16;
+
+	*nsets = 0;
+
+	rel = ticker_open_readable("pglogical", "replication_set");
+	if (rel == NULL)
+		return NULL;
+
+	attnum = get_attnum(RelationGetRelid(rel), "set_name");
+	if (attnum == InvalidAttrNumber)
+		elog(ERROR, "pglogical.replication_set has no column set_name");
+
+	sets = (NameData *) palloc(maxsets * sizeof(NameData));
+
+	scan = table_beginscan(rel, GetActiveSnapshot(), 0, NULL);
+	while ((tup = heap_getnext(scan, ForwardScanDirection)) != NULL)
+	{
+		bool		isnull;
+		Datum		value;
+
+		value = heap_getattr(tup, attnum, RelationGetDescr(rel), &isnull);
+		if (isnull)
+			continue;
+		if (*nsets == maxsets)
+		{
+			maxsets *= 2;
+			sets = (NameData *) repalloc(sets, maxsets * sizeof(NameData));
+		}
+		namestrcpy(&sets[(*nsets)++], NameStr(*DatumGetName(value)));
+	}
+	table_endscan(scan);
+	relation_close(rel, AccessShareLock);
+
+	*nsets = ticker_sort_names(sets, *nsets);
+
+	return sets;
+}
+
+/*
+ * Distinct names of the replication sets subscribed to, sorted.
+ */
+static NameData *
+ticker_subscribed_sets(int *nsets)
+{
+	Relation	rel;
+	TableScanDesc scan;
+	HeapTuple	tup;
+	AttrNumber	attnum;
+	NameData   *sets;
+	int			maxsets = 16;
+	int			i;
+
+	*nsets = 0;
+
+	rel = ticker_open_readable("pglogical", "subscription");
+	if (rel == NULL)
+		return NULL;
+
+	attnum = get_attnum(RelationGetRelid(rel), "sub_replication_sets");
+	if (attnum == InvalidAttrNumber)
+		elog(ERROR, "pglogical.subscription has no column sub_replication_sets");
+
+	sets = (NameData *) palloc(maxsets * sizeof(NameData));
+
+	scan = table_beginscan(rel, GetActiveSnapshot(), 0, NULL);
+	while ((tup = heap_getnext(scan, ForwardScanDirection)) != NULL)
+	{
+		bool		isnull;
+		Datum		value;
+		Datum	   *elems;
+		bool	   *elemnulls;
+		int			nelems;
+
+		value = heap_getattr(tup, attnum, RelationGetDescr(rel), &isnull);
+		if (isnull)
+			continue;
+
+		deconstruct_array(DatumGetArrayTypeP(value), TEXTOID, -1, false, 'i',
+						  &elems, &elemnulls, &nelems);
+		for (i = 0; i < nelems; i++)
+		{
+			char	   *set_name;
+
+			if (elemnulls[i])
+				continue;
+			if (*nsets == maxsets)
+			{
+				maxsets *= 2;
+				sets = (NameData *) repalloc(sets, maxsets * sizeof(NameData));
+			}
+			set_name = TextDatumGetCString(elems[i]);
+			namestrcpy(&sets[(*nsets)++], set_name);
+			pfree(set_name);
+		}
+	}
+	table_endscan(scan);
+	relation_close(rel, AccessShareLock);
+
+	/* Several subscriptions may subscribe to the same set */
+	*nsets = ticker_sort_names(sets, *nsets);
+
+	return sets;
+}
+
+/*
+ * Interval in microseconds, counting months and years the way
+ * extract(epoch FROM interval) does, as the worker does.
+ */
+static int64
+ticker_interval_us(Interval *span)
+{
+	return span->time + span->day * USECS_PER_DAY +
+		(int64) ((span->month / MONTHS_PER_YEAR) * DAYS_PER_YEAR * USECS_PER_DAY) +
+		(int64) (span->month % MONTHS_PER_YEAR) * DAYS_PER_MONTH * USECS_PER_DAY;
+}
+
+/*
+ * Tick intervals configured in pglogical_ticker.set_config.
+ */
+static TickerSetInterval *
+ticker_set_intervals(int *nintervals)
+{
+	Relation	rel;
+	TableScanDesc scan;
+	HeapTuple	tup;
+	TickerSetInterval *intervals;
+	int			maxintervals = 16;
+
+	*nintervals = 0;
+
+	rel = ticker_open_readable("pglogical_ticker", "set_config");
+	if (rel == NULL)
+		return NULL;
+
+	intervals = (TickerSetInterval *)
+		palloc(maxintervals * sizeof(TickerSetInterval));
+
+	scan = table_beginscan(rel, GetActiveSnapshot(), 0, NULL);
+	while ((tup = heap_getnext(scan, ForwardScanDirection)) != NULL)
+	{
+		TupleDesc	tupdesc = RelationGetDescr(rel);
+		bool		isnull;
+		Datum		set_name;
+		Datum		tick_interval;
+
+		set_name = heap_getattr(tup, Anum_set_config_set_name, tupdesc, &isnull);
+		tick_interval = heap_getattr(tup, Anum_set_config_tick_interval,
+									 tupdesc, &isnull);
+		if (isnull)
+			continue;
+
+		if (*nintervals == maxintervals)
+		{
+			maxintervals *= 2;
+			intervals = (TickerSetInterval *)
+				repalloc(intervals, maxintervals * sizeof(TickerSetInterval));
+		}
+		namestrcpy(&intervals[*nintervals].set_name,
+				   NameStr(*DatumGetName(set_name)));
+		intervals[*nintervals].interval =
+			ticker_interval_us(DatumGetIntervalP(tick_interval));
+		(*nintervals)++;
+	}
+	table_endscan(scan);
+	relation_close(rel, AccessShareLock);
+
+	return intervals;
+}
+
+/*
+ * Commit time of the transaction that wrote a ticker row, if commit
+ * timestamps are to be used and are known for it.  Rows whose commit
+ * timestamp was not tracked, or was truncated away, fall back to their
+ * source_time.
+ */
+static bool
+ticker_commit_time(HeapTuple tup, TimestampTz *commit_time)
+{
+	if (!pglogical_ticker_use_commit_timestamp || !track_commit_timestamp)
+		return false;
+
+	return TransactionIdGetCommitTsData(HeapTupleHeaderGetXmin(tup->t_data),
+										commit_time, NULL) &&
+		*commit_time != 0;
+}
+
+/*
+ * Called for each row of the ticker table of a subscribed set, with the tick
+ * interval of the set in microseconds.
+ */
+typedef void (*TickerLagCallback) (Name set_name, int64 interval,
+								   Datum provider_name, bool provider_isnull,
+								   Datum source_time, bool source_isnull,
+								   void *arg);
+
+/*
+ * Scan the ticker tables of the given replication sets, skipping the sets
+ * which have none.
+ */
+static void
+ticker_scan_sets(NameData *sets, int nsets, TickerLagCallback callback, void *arg)
+{
+	TickerSetInterval *intervals;
+	int			nintervals;
+	int			i;
+	int			j;
+
+	intervals = ticker_set_intervals(&nintervals);
+
+	for (i = 0; i < nsets; i++)
+	{
+		Relation	rel;
+		TableScanDesc scan;
+		HeapTuple	tup;
+		int64		interval = pglogical_ticker_interval_ms() * 1000L;
+
+		rel = ticker_open_readable("pglogical_ticker", NameStr(sets[i]));
+		if (rel == NULL)
+			continue;
+
+		for (j = 0; j < nintervals; j++)
+		{
+			if (strcmp(NameStr(intervals[j].set_name), NameStr(sets[i])) == 0)
+				interval = intervals[j].interval;
+		}
+
+		scan = table_beginscan(rel, GetActiveSnapshot(), 0, NULL);
+		while ((tup = heap_getnext(scan, ForwardScanDirection)) != NULL)
+		{
+			Datum		provider_name;
+			Datum		source_time;
+			bool		provider_isnull;
+			bool		source_isnull;
+			TimestampTz commit_time;
+
+			provider_name = heap_getattr(tup, Anum_ticker_provider_name,
+										 RelationGetDescr(rel), &provider_isnull);
+			source_time = heap_getattr(tup, Anum_ticker_source_time,
+									   RelationGetDescr(rel), &source_isnull);
+
+			if (ticker_commit_time(tup, &commit_time))
+			{
+				source_time = TimestampTzGetDatum(commit_time);
+				source_isnull = false;
+			}
+
+			callback(&sets[i], interval, provider_name, provider_isnull,
+					 source_time, source_isnull, arg);
+		}
+		table_endscan(scan);
+		relation_close(rel, AccessShareLock);
+	}
+}
+
+/*
+ * Scan the ticker tables of every subscribed replication set.
+ */
+static void
+ticker_scan_subscribed(TickerLagCallback callback, void *arg)
+{
+	NameData   *sets;
+	int			nsets;
+
+	sets = ticker_subscribed_sets(&nsets);
+	ticker_scan_sets(sets, nsets, callback, arg);
+}
+
+typedef struct TickerLagState
+{
+	Tuplestorestate *tupstore;
+	TupleDesc	tupdesc;
+	TimestampTz now;
+} TickerLagState;
+
+static void
+ticker_lag_row(Name set_name, int64 interval,
+			   Datum provider_name, bool provider_isnull,
+			   Datum source_time, bool source_isnull, void *arg)
+{
+	TickerLagState *state = (TickerLagState *) arg;
+	Datum		values[5];
+	bool		nulls[5];
+
+	memset(nulls, 0, sizeof(nulls));
+
+	values[0] = provider_name;
+	nulls[0] = provider_isnull;
+	values[1] = NameGetDatum(set_name);
+	values[2] = source_time;
+	nulls[2] = source_isnull;
+
+	if (source_isnull)
+	{
+		nulls[3] = true;
+		nulls[4] = true;
+	}
+	else
+	{
+		values[3] = DirectFunctionCall2(timestamp_mi,
+										TimestampTzGetDatum(state->now),
+										source_time);
+		if (state->now - interval > DatumGetTimestampTz(source_time))
+			values[4] = DirectFunctionCall2(timestamp_mi,
+											TimestampTzGetDatum(state->now - interval),
+											source_time);
+		else
+			values[4] = IntervalPGetDatum((Interval *) palloc0(sizeof(Interval)));
+	}
+
+	tuplestore_putvalues(state->tupstore, state->tupdesc, values, nulls);
+}
+
+/*
+ * SQL function pglogical_ticker.lag()
+ *		Replication lag of every subscribed replication set that has a
+ *		ticker table, per provider.
+ *
+ * lag is how long ago the last tick that was applied here happened on the
+ * provider.  Even without any delay, it grows up to the tick interval
+ * between two ticks, so staleness is lag minus the tick interval of the set,
+ * and is zero as long as ticks arrive on time.  The interval is taken from
+ * set_config on this node, or pglogical_ticker.naptime.
+ */
+Datum
+pglogical_ticker_lag(PG_FUNCTION_ARGS)
+{
+	TickerLagState state;
+
+	state.tupstore = ticker_materialized_srf(fcinfo, &state.tupdesc);
+	state.now = GetCurrentTransactionStartTimestamp();
+
+	ticker_scan_subscribed(ticker_lag_row, &state);
+
+	return (Datum) 0;
+}
+
+typedef struct TickerTickersState
+{
+	Tuplestorestate *tupstore;
+	TupleDesc	tupdesc;
+	int64		nrows;
+} TickerTickersState;
+
+static void
+ticker_tickers_row(Name set_name, int64 interval,
+				   Datum provider_name, bool provider_isnull,
+				   Datum source_time, bool source_isnull, void *arg)
+{
+	TickerTickersState *state = (TickerTickersState *) arg;
+	Datum		values[3];
+	bool		nulls[3];
+
+	values[0] = provider_name;
+	nulls[0] = provider_isnull;
+	values[1] = NameGetDatum(set_name);
+	nulls[1] = false;
+	values[2] = source_time;
+	nulls[2] = source_isnull;
+
+	tuplestore_putvalues(state->tupstore, state->tupdesc, values, nulls);
+	state->nrows++;
+}
+
+/*
+ * Without any ticker table, the SQL versions of all_repset_tickers() and
+ * all_subscription_tickers() returned a single row of NULLs, keep doing so.
+ */
+static void
+ticker_tickers_finish(TickerTickersState *state)
+{
+	Datum		values[3];
+	bool		nulls[3] = {true, true, true};
+
+	if (state->nrows == 0)
+		tuplestore_putvalues(state->tupstore, state->tupdesc, values, nulls);
+}
+
+/*
+ * SQL function pglogical_ticker.all_repset_tickers()
+ *		Last tick of every replication set of this node that has a ticker
+ *		table, per provider.
+ */
+Datum
+pglogical_ticker_all_repset_tickers(PG_FUNCTION_ARGS)
+{
+	TickerTickersState state;
+	NameData   *sets;
+	int			nsets;
+
+	state.tupstore = ticker_materialized_srf(fcinfo, &state.tupdesc);
+	state.nrows = 0;
+
+	sets = ticker_repset_names(&nsets);
+	ticker_scan_sets(sets, nsets, ticker_tickers_row, &state);
+	ticker_tickers_finish(&state);
+
+	return (Datum) 0;
+}
+
+/*
+ * SQL function pglogical_ticker.all_subscription_tickers()
+ *		Last tick applied of every subscribed replication set that has a
+ *		ticker table, per provider.
+ */
+Datum
+pglogical_ticker_all_subscription_tickers(PG_FUNCTION_ARGS)
+{
+	TickerTickersState state;
+
+	state.tupstore = ticker_materialized_srf(fcinfo, &state.tupdesc);
+	state.nrows = 0;
+
+	ticker_scan_subscribed(ticker_tickers_row, &state);
+	ticker_tickers_finish(&state);
+
+	return (Datum) 0;
+}
+
+static void
+ticker_lag_sample_row(Name set_name, int64 interval,
+					  Datum provider_name, bool provider_isnull,
+					  Datum source_time, bool source_isnull, void *arg)
+{
+	TimestampTz now = *(TimestampTz *) arg;
+	TickerLagSample *sample;
+
+	if (provider_isnull || source_isnull)
+		return;
+
+	ticker_lag_record(MyDatabaseId, DatumGetName(provider_name), set_name,
+					  now - DatumGetTimestampTz(source_time));
+
+	if (!pglogical_ticker_lag_history)
+		return;
+
+	if (ticker_nlag_samples == ticker_maxlag_samples)
+	{
+		if (ticker_lag_samples == NULL)
+		{
+			ticker_maxlag_samples = 64;
+			ticker_lag_samples = (TickerLagSample *)
+				MemoryContextAlloc(TopMemoryContext,
+								   ticker_maxlag_samples * sizeof(TickerLagSample));
+		}
+		else
+		{
+			ticker_maxlag_samples *= 2;
+			ticker_lag_samples = (TickerLagSample *)
+				repalloc(ticker_lag_samples,
+						 ticker_maxlag_samples * sizeof(TickerLagSample));
+		}
+	}
+
+	sample = &ticker_lag_samples[ticker_nlag_samples++];
+	sample->sample_time = now;
+	namestrcpy(&sample->provider_name, NameStr(*DatumGetName(provider_name)));
+	namestrcpy(&sample->set_name, NameStr(*set_name));
+	sample->lag = now - DatumGetTimestampTz(source_time);
+}
+
+static ArrayType *
+ticker_build_array(Datum *elems, int nelems, Oid elemtype)
+{
+	int16		typlen;
+	bool		typbyval;
+	char		typalign;
+
+	get_typlenbyvalalign(elemtype, &typlen, &typbyval, &typalign);
+	return construct_array(elems, nelems, elemtype, typlen, typbyval, typalign);
+}
+
+/*
+ * Is there a lag history table?  It needs PostgreSQL 10 and version 1.5 of
+ * the extension.
+ */
+static bool
+ticker_has_lag_history(void)
+{
+	Oid			nspid = get_namespace_oid("pglogical_ticker", true);
+
+	return OidIsValid(nspid) &&
+		OidIsValid(get_relname_relid("lag_history", nspid));
+}
+
+/*
+ * Write the buffered lag samples to pglogical_ticker.lag_history with a
+ * single INSERT.  The partitions they go to are created ahead by
+ * pglogical_ticker_lag_history_maintenance().
+ *
+ * Samples are dropped if there is no lag history table.
+ */
+static void
+ticker_lag_history_flush(void)
+{
+	Datum	   *sample_times;
+	Datum	   *provider_names;
+	Datum	   *set_names;
+	Datum	   *lags;
+	Datum		args[4];
+	int			i;
+	int			ret;
+
+	if (!ticker_has_lag_history())
+	{
+		ticker_nlag_samples = 0;
+		return;
+	}
+
+	SPI_connect();
+
+	if (ticker_lag_history_plan == NULL)
+	{
+		Oid			argtypes[4];
+
+		argtypes[0] = get_array_type(TIMESTAMPTZOID);
+		argtypes[1] = get_array_type(NAMEOID);
+		argtypes[2] = get_array_type(NAMEOID);
+		argtypes[3] = get_array_type(INTERVALOID);
+
+		ticker_lag_history_plan = ticker_prepare_kept(
+			"INSERT INTO pglogical_ticker.lag_history "
+			"(sample_time, provider_name, set_name, lag) "
+			"SELECT * FROM unnest($1, $2, $3, $4)",
+			4, argtypes);
+	}
+
+	sample_times = (Datum *) palloc(ticker_nlag_samples * sizeof(Datum));
+	provider_names = (Datum *) palloc(ticker_nlag_samples * sizeof(Datum));
+	set_names = (Datum *) palloc(ticker_nlag_samples * sizeof(Datum));
+	lags = (Datum *) palloc(ticker_nlag_samples * sizeof(Datum));
+
+	for (i = 0; i < ticker_nlag_samples; i++)
+	{
+		Interval   *lag = (Interval *) palloc0(sizeof(Interval));
+
+		lag->time = ticker_lag_samples[i].lag;
+		sample_times[i] = TimestampTzGetDatum(ticker_lag_samples[i].sample_time);
+		provider_names[i] = NameGetDatum(&ticker_lag_samples[i].provider_name);
+		set_names[i] = NameGetDatum(&ticker_lag_samples[i].set_name);
+		lags[i] = IntervalPGetDatum(lag);
+	}
+
+	args[0] = PointerGetDatum(ticker_build_array(sample_times, ticker_nlag_samples,
+												 TIMESTAMPTZOID));
+	args[1] = PointerGetDatum(ticker_build_array(provider_names, ticker_nlag_samples,
+												 NAMEOID));
+	args[2] = PointerGetDatum(ticker_build_array(set_names, ticker_nlag_samples,
+												 NAMEOID));
+	args[3] = PointerGetDatum(ticker_build_array(lags, ticker_nlag_samples,
+												 INTERVALOID));
+
+	ret = SPI_execute_plan(ticker_lag_history_plan, args, NULL, false, 0);
+	if (ret != SPI_OK_INSERT)
+		elog(ERROR, "pglogical_ticker: could not write lag history: %s",
+			 SPI_result_code_string(ret));
+
+	SPI_finish();
+
+	ticker_nlag_samples = 0;
+}
+
+/*
+ * Run pglogical_ticker.lag_history_maintenance(), which creates the
+ * partitions of the lag history ahead, rolls the samples up and drops
+ * expired partitions.  Called by the worker, in a transaction of its own
+ * with an active snapshot, every hour while pglogical_ticker.lag_history
+ * is on, whether or not there are samples to write.
+ */
+void
+pglogical_ticker_lag_history_maintenance(void)
+{
+	int			ret;
+
+	if (!ticker_has_lag_history())
+		return;
+
+	SPI_connect();
+
+	ret = SPI_execute("SELECT pglogical_ticker.lag_history_maintenance()",
+					  false, 0);
+	if (ret != SPI_OK_SELECT)
+		elog(ERROR, "pglogical_ticker: could not run lag history maintenance: %s",
+			 SPI_result_code_string(ret));
+
+	SPI_finish();
+}
+
+/*
+ * Add the current lag of every subscribed set to the lag histograms in
+ * shared memory, and to the lag history if it is kept.  Called by the
+ * worker, in a transaction with an active snapshot, every
+ * pglogical_ticker.lag_sample_interval_ms.
+ */
+void
+pglogical_ticker_sample_lag(void)
+{
+	TimestampTz now = GetCurrentTimestamp();
+
+	ticker_scan_subscribed(ticker_lag_sample_row, &now);
+
+	if (!pglogical_ticker_lag_history)
+		ticker_nlag_samples = 0;
+	else if (ticker_nlag_samples >= TICKER_LAG_HISTORY_BATCH ||
+			 (ticker_nlag_samples > 0 &&
+			  now - ticker_lag_samples[0].sample_time >= TICKER_LAG_HISTORY_FLUSH_US))
+		ticker_lag_history_flush();
+}
+
+/*
+ * Trigger function pglogical_ticker.apply_trigger()
+ *		BEFORE INSERT OR UPDATE row trigger on ticker tables, enabled for
+ *		replica sessions only, which logs each tick applied by pglogical
+ *		with the local time it was applied at.
+ *
+ * This is on the apply path, so it only reads the new row in place, and
+ * does not even build the set name: the ticker table is named after it.
+ * With pglogical_ticker.use_commit_timestamp, the commit time of the tick
+ * on the provider is taken from the replication origin of the session.
+ */
+Datum
+pglogical_ticker_apply_trigger(PG_FUNCTION_ARGS)
+{
+	TriggerData *trigdata = (TriggerData *) fcinfo->context;
+	HeapTuple	tuple;
+	TupleDesc	tupdesc;
+	Datum		provider_name;
+	Datum		source_time;
+	bool		isnull;
+
+	if (!CALLED_AS_TRIGGER(fcinfo))
+		elog(ERROR, "pglogical_ticker_apply_trigger: not called by trigger manager");
+	if (!TRIGGER_FIRED_BEFORE(trigdata->tg_event) ||
+		!TRIGGER_FIRED_FOR_ROW(trigdata->tg_event))
+		elog(ERROR, "pglogical_ticker_apply_trigger: must be fired before row");
+
+	if (TRIGGER_FIRED_BY_UPDATE(trigdata->tg_event))
+		tuple = trigdata->tg_newtuple;
+	else
+		tuple = trigdata->tg_trigtuple;
+	tupdesc = RelationGetDescr(trigdata->tg_relation);
+
+	provider_name = heap_getattr(tuple, Anum_ticker_provider_name, tupdesc, &isnull);
+	if (isnull)
+		return PointerGetDatum(tuple);
+	source_time = heap_getattr(tuple, Anum_ticker_source_time, tupdesc, &isnull);
+	if (pglogical_ticker_use_commit_timestamp &&
+		replorigin_session_origin_timestamp != 0)
+	{
+		source_time = TimestampTzGetDatum(replorigin_session_origin_timestamp);
+		isnull = false;
+	}
+	if (isnull)
+		return PointerGetDatum(tuple);
+
+	ticker_apply_record(MyDatabaseId,
+						DatumGetName(provider_name),
+						&trigdata->tg_relation->rd_rel->relname,
+						DatumGetTimestampTz(source_time),
+						GetCurrentTimestamp());
+
+	return PointerGetDatum(tuple);
+}
@@ -0,0 +1,1676 @@
+/* -------------------------------------------------------------------------
+ *
+ * pglogical_ticker_shmem.c
+ *		Shared memory status registry of the ticker workers.
+ *
+ * When pglogical_ticker is in shared_preload_libraries, the workers record
+ * the outcome of every tick per (database, replication set) here, so that
+ * monitoring can read ticker health without touching any table.
+ *
+ * On subscribers, the workers also keep a histogram of the sampled lag per
+ * (database, provider, replication set) here, and the apply trigger of the
+ * ticker tables logs every tick it sees applied into a ring buffer.
+ *
+ * pglogical_ticker.tick_now() asks the worker of the database to tick some
+ * sets right away, through the worker's slot in here, and waits for it.
+ *
+ * pglogical_ticker.metrics() exposes the worker and set counters in the
+ * Prometheus text format, for exporters that scrape many databases.
+ *
+ * -------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include <math.h>
+
+#include "funcapi.h"
+#include "miscadmin.h"
+#include "pgstat.h"
+#include "catalog/pg_type.h"
+#include "commands/dbcommands.h"
+#include "port/atomics.h"
+#include "storage/ipc.h"
+#include "storage/latch.h"
+#include "storage/lwlock.h"
+#include "storage/shmem.h"
+#include "lib/stringinfo.h"
+#include "utils/array.h"
+#include "utils/builtins.h"
+#include "utils/hsearch.h"
+#include "utils/pg_lsn.h"
+#include "utils/timestamp.h"
+
+#include "pglogical_ticker.h"
+
+typedef struct TickerSharedState
+{
+	LWLock	   *lock;			/* protects everything in here */
+	int			nworkers;		/* size of workers[] */
+	TickerWorkerStatus workers[FLEXIBLE_ARRAY_MEMBER];
+} TickerSharedState;
+
+/*
+ * Lag histograms have a bucket for lags under 1 ms, and then
+ * TICKER_LAG_BUCKETS_PER_DOUBLING buckets for each doubling of the lag,
+ * which bounds the error of a percentile to about 19%.  The last bucket,
+ * from about 40 days on, is open-ended.
+ */
+#define TICKER_LAG_BUCKETS					128
+#define TICKER_LAG_BUCKETS_PER_DOUBLING		4
+
+typedef struct TickerLagKey
+{
+	Oid			dbid;
+	NameData	provider_name;
+	NameData	set_name;
+} TickerLagKey;
+
+typedef struct TickerLagHistogram
+{
+	TickerLagKey key;
+	TimestampTz since;			/* first sample of the window */
+	int64		samples;
+	int64		max_lag;		/* microseconds */
+	int64		buckets[TICKER_LAG_BUCKETS];
+} TickerLagHistogram;
+
+/*
+ * Ring buffer of applied ticks.  Writers claim a position by incrementing
+ * next, without any lock, so that the apply trigger never waits.  The seq of
+ * an event is 0 while it is being written and its position + 1 once it is
+ * complete, which lets readers detect events that are incomplete or got
+ * overwritten while they were copying them.
+ */
+typedef struct TickerApplyEvent
+{
+	pg_atomic_uint64 seq;
+	Oid			dbid;
+	NameData	provider_name;
+	NameData	set_name;
+	TimestampTz source_time;
+	TimestampTz apply_time;
+} TickerApplyEvent;
+
+typedef struct TickerApplyRing
+{
+	pg_atomic_uint64 next;		/* position of the next event */
+	int			size;			/* number of events[] */
+	TickerApplyEvent events[FLEXIBLE_ARRAY_MEMBER];
+} TickerApplyRing;
+
+/* Upper bounds of the tick duration buckets but the last, in microseconds */
+static const int64 ticker_tick_duration_bounds[TICKER_TICK_DURATION_BUCKETS - 1] = {
+	1000, 2500, 5000, 10000, 25000, 50000, 100000,
+	250000, 500000, 1000000, 2500000, 5000000, 10000000
+};
+
+/*
+ * Weight of the last tick in the moving average of each phase, which then
+ * mostly reflects the last few dozen ticks.
+ */
+#define TICKER_PHASE_RECENT_WEIGHT	0.05
+
+static const char *const ticker_phase_names[TICKER_NUM_PHASES] = {
+	"start_transaction",
+	"spi_connect",
+	"execute",
+	"commit",
+	"report_stat"
+};
+
+/* GUC variables */
+int			pglogical_ticker_max_tracked_sets = 1024;
+int			pglogical_ticker_apply_ring_size = 1024;
+
+static TickerSharedState *ticker_state = NULL;
+static HTAB *ticker_status_hash = NULL;
+static HTAB *ticker_lag_hash = NULL;
+static TickerApplyRing *ticker_apply_ring = NULL;
+
+/* Worker slot of this process, if it is a ticker worker */
+static TickerWorkerStatus *MyTickerWorker = NULL;
+
+#if PG_VERSION_NUM >= 150000
+static shmem_request_hook_type prev_shmem_request_hook = NULL;
+#endif
+static shmem_startup_hook_type prev_shmem_startup_hook = NULL;
+
+PG_FUNCTION_INFO_V1(pglogical_ticker_worker_status);
+PG_FUNCTION_INFO_V1(pglogical_ticker_worker_stats);
+PG_FUNCTION_INFO_V1(pglogical_ticker_lag_histogram);
+PG_FUNCTION_INFO_V1(pglogical_ticker_lag_histogram_reset);
+PG_FUNCTION_INFO_V1(pglogical_ticker_apply_events);
+PG_FUNCTION_INFO_V1(pglogical_ticker_metrics);
+PG_FUNCTION_INFO_V1(pglogical_ticker_tick_phase_stats);
+PG_FUNCTION_INFO_V1(pglogical_ticker_tick_commits);
+PG_FUNCTION_INFO_V1(pglogical_ticker_tick_now);
+
+/*
+ * One worker slot per possible background worker; there is at most one
+ * ticker per database.
+ */
+static Size
+ticker_state_size(void)
+{
+	return add_size(offsetof(TickerSharedState, workers),
+					mul_size(max_worker_processes, sizeof(TickerWorkerStatus)));
+}
+
+static Size
+ticker_apply_ring_size(void)
+{
+	return add_size(offsetof(TickerApplyRing, events),
+					mul_size(pglogical_ticker_apply_ring_size,
+							 sizeof(TickerApplyEvent)));
+}
+
+static Size
+ticker_shmem_size(void)
+{
+	Size		size;
+
+	size = MAXALIGN(ticker_state_size());
+	size = add_size(size, MAXALIGN(ticker_apply_ring_size()));
+	size = add_size(size, hash_estimate_size(pglogical_ticker_max_tracked_sets,
+											 sizeof(TickerSetStatus)));
+	size = add_size(size, hash_estimate_size(pglogical_ticker_max_tracked_sets,
+											 sizeof(TickerLagHistogram)));
+
+	return size;
+}
+
+static void
+ticker_shmem_request(void)
+{
+#if PG_VERSION_NUM >= 150000
+	if (prev_shmem_request_hook)
+		prev_shmem_request_hook();
+#endif
+
+	RequestAddinShmemSpace(ticker_shmem_size());
+#if PG_VERSION_NUM >= 90600
+	RequestNamedLWLockTranche("pglogical_ticker", 1);
+#else
+	RequestAddinLWLocks(1);
+#endif
+}
+
+static void
+ticker_shmem_startup(void)
+{
+	bool		found;
+	HASHCTL		info;
+
+	if (prev_shmem_startup_hook)
+		prev_shmem_startup_hook();
+
+	LWLockAcquire(AddinShmemInitLock, LW_EXCLUSIVE);
+
+	ticker_state = ShmemInitStruct("pglogical_ticker",
+								   ticker_state_size(),
+								   &found);
+	if (!found)
+	{
+		memset(ticker_state, 0, ticker_state_size());
+		ticker_state->nworkers = max_worker_processes;
+#if PG_VERSION_NUM >= 90600
+		ticker_state->lock = &(GetNamedLWLockTranche("pglogical_ticker"))->lock;
+#else
+		ticker_state->lock = LWLockAssign();
+#endif
+	}
+
+	ticker_apply_ring = ShmemInitStruct("pglogical_ticker apply ring",
+										ticker_apply_ring_size(),
+										&found);
+	if (!found)
+	{
+		int			i;
+
+		pg_atomic_init_u64(&ticker_apply_ring->next, 0);
+		ticker_apply_ring->size = pglogical_ticker_apply_ring_size;
+		for (i = 0; i < ticker_apply_ring->size; i++)
+			pg_atomic_init_u64(&ticker_apply_ring->events[i].seq, 0);
+	}
+
+	memset(&info, 0, sizeof(info));
+	info.keysize = sizeof(TickerSetStatusKey);
+	info.entrysize = sizeof(TickerSetStatus);
+	ticker_status_hash = ShmemInitHash("pglogical_ticker set status",
+									   pglogical_ticker_max_tracked_sets,
+									   pglogical_ticker_max_tracked_sets,
+									   &info,
+									   HASH_ELEM | HASH_BLOBS);
+
+	memset(&info, 0, sizeof(info));
+	info.keysize = sizeof(TickerLagKey);
+	info.entrysize = sizeof(TickerLagHistogram);
+	ticker_lag_hash = ShmemInitHash("pglogical_ticker lag histograms",
+									pglogical_ticker_max_tracked_sets,
+									pglogical_ticker_max_tracked_sets,
+									&info,
+									HASH_ELEM | HASH_BLOBS);
+
+	LWLockRelease(AddinShmemInitLock);
+}
+
+/*
+ * Reserve the shared memory.  Only called from _PG_init while processing
+ * shared_preload_libraries.
+ */
+void
+pglogical_ticker_shmem_init(void)
+{
+#if PG_VERSION_NUM >= 150000
+	prev_shmem_request_hook = shmem_request_hook;
+	shmem_request_hook = ticker_shmem_request;
+#else
+	ticker_shmem_request();
+#endif
+	prev_shmem_startup_hook = shmem_startup_hook;
+	shmem_startup_hook = ticker_shmem_startup;
+}
+
+bool
+pglogical_ticker_shmem_enabled(void)
+{
+	return ticker_state != NULL;
+}
+
+static void
+ticker_shmem_require(void)
+{
+	if (ticker_state == NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("pglogical_ticker must be loaded via shared_preload_libraries")));
+}
+
+static void
+ticker_worker_detach(int code, Datum arg)
+{
+	LWLockAcquire(ticker_state->lock, LW_EXCLUSIVE);
+	MyTickerWorker->pid = 0;
+	MyTickerWorker->latch = NULL;
+	LWLockRelease(ticker_state->lock);
+
+	MyTickerWorker = NULL;
+}
+
+/*
+ * Claim the worker slot of a database for this process.  A slot which was
+ * used by an earlier worker of the same database is reused, so that its
+ * counters carry on across worker restarts.  Otherwise an unused slot is
+ * taken, or failing that the slot of a database without the extension.
+ *
+ * Returns false if another worker is running for this database.
+ */
+bool
+ticker_worker_attach(Oid dbid)
+{
+	TickerWorkerStatus *match = NULL;
+	TickerWorkerStatus *unused = NULL;
+	TickerWorkerStatus *reusable = NULL;
+	TickerWorkerStatus *slot;
+	int			i;
+
+	if (ticker_state == NULL)
+		return true;
+
+	LWLockAcquire(ticker_state->lock, LW_EXCLUSIVE);
+	for (i = 0; i < ticker_state->nworkers; i++)
+	{
+		TickerWorkerStatus *w = &ticker_state->workers[i];
+
+		if (w->dbid == dbid)
+		{
+			match = w;
+			break;
+		}
+		if (unused == NULL && w->dbid == InvalidOid)
+			unused = w;
+		if (reusable == NULL && w->pid == 0 && w->extension_missing)
+			reusable = w;
+	}
+
+	if (match != NULL && match->pid != 0 && match->pid != MyProcPid)
+	{
+		LWLockRelease(ticker_state->lock);
+		return false;
+	}
+
+	slot = match ? match : (unused ? unused : reusable);
+	if (slot != NULL && slot != match)
+	{
+		memset(slot, 0, sizeof(TickerWorkerStatus));
+		slot->dbid = dbid;
+	}
+	if (slot != NULL)
+	{
+		slot->pid = MyProcPid;
+		slot->latch = MyLatch;
+		slot->starts++;
+		slot->extension_missing = false;
+		slot->ready = false;
+	}
+	LWLockRelease(ticker_state->lock);
+
+	if (slot == NULL)
+	{
+		elog(WARNING, "pglogical_ticker: no free worker slot in shared memory");
+		return true;
+	}
+
+	MyTickerWorker = slot;
+	before_shmem_exit(ticker_worker_detach, (Datum) 0);
+
+	return true;
+}
+
+/*
+ * Remember that the database of this worker does not have the extension.
+ */
+void
+ticker_worker_set_extension_missing(void)
+{
+	if (MyTickerWorker == NULL)
+		return;
+
+	LWLockAcquire(ticker_state->lock, LW_EXCLUSIVE);
+	MyTickerWorker->extension_missing = true;
+	LWLockRelease(ticker_state->lock);
+}
+
+/*
+ * Remember that the worker of this database is past its start-up checks, and
+ * is going to tick.
+ */
+void
+ticker_worker_set_ready(void)
+{
+	if (MyTickerWorker == NULL)
+		return;
+
+	LWLockAcquire(ticker_state->lock, LW_EXCLUSIVE);
+	MyTickerWorker->ready = true;
+	LWLockRelease(ticker_state->lock);
+}
+
+/*
+ * What do the workers of this database tell about it?
+ */
+TickerDbState
+ticker_worker_db_state(Oid dbid)
+{
+	TickerDbState state = TICKER_DB_UNKNOWN;
+	int			i;
+
+	if (ticker_state == NULL)
+		return TICKER_DB_UNKNOWN;
+
+	LWLockAcquire(ticker_state->lock, LW_SHARED);
+	for (i = 0; i < ticker_state->nworkers; i++)
+	{
+		TickerWorkerStatus *w = &ticker_state->workers[i];
+
+		if (w->dbid != dbid)
+			continue;
+
+		if (w->extension_missing)
+			state = TICKER_DB_MISSING;
+		else if (!w->ready)
+			state = TICKER_DB_UNKNOWN;
+		else if (w->pid != 0)
+			state = TICKER_DB_RUNNING;
+		else
+			state = TICKER_DB_STOPPED;
+		break;
+	}
+	LWLockRelease(ticker_state->lock);
+
+	return state;
+}
+
+/*
+ * Count a tick fired by the scheduler of this worker.
+ */
+void
+ticker_worker_count_tick(int64 interval, bool late, int64 missed)
+{
+	if (MyTickerWorker == NULL)
+		return;
+
+	LWLockAcquire(ticker_state->lock, LW_EXCLUSIVE);
+	MyTickerWorker->interval = interval;
+	MyTickerWorker->ticks++;
+	if (late)
+		MyTickerWorker->late_ticks++;
+	MyTickerWorker->missed_ticks += missed;
+	LWLockRelease(ticker_state->lock);
+}
+
+/*
+ * Count the duration of a successful tick, in microseconds, and log its
+ * commit LSN unless it wrote no commit record.
+ */
+void
+ticker_worker_count_tick_done(TimestampTz tick_time, int64 duration,
+							  XLogRecPtr commit_lsn)
+{
+	TickerCommit *commit;
+
+	int			bucket;
+
+	if (MyTickerWorker == NULL)
+		return;
+
+	for (bucket = 0; bucket < TICKER_TICK_DURATION_BUCKETS - 1; bucket++)
+	{
+		if (duration <= ticker_tick_duration_bounds[bucket])
+			break;
+	}
+
+	LWLockAcquire(ticker_state->lock, LW_EXCLUSIVE);
+	MyTickerWorker->tick_duration_sum += duration;
+	MyTickerWorker->tick_durations[bucket]++;
+	if (!XLogRecPtrIsInvalid(commit_lsn))
+	{
+		commit = &MyTickerWorker->commits[MyTickerWorker->ncommits++ % TICKER_COMMIT_HISTORY];
+		commit->tick_time = tick_time;
+		commit->commit_lsn = commit_lsn;
+	}
+	LWLockRelease(ticker_state->lock);
+}
+
+/*
+ * Add the duration of each phase of a successful tick, in microseconds.
+ */
+void
+ticker_worker_count_phases(int64 *durations)
+{
+	int			i;
+
+	if (MyTickerWorker == NULL)
+		return;
+
+	LWLockAcquire(ticker_state->lock, LW_EXCLUSIVE);
+	for (i = 0; i < TICKER_NUM_PHASES; i++)
+	{
+		TickerPhaseStats *phase = &MyTickerWorker->phases[i];
+
+		if (phase->calls == 0)
+			phase->recent = durations[i];
+		else
+			phase->recent += TICKER_PHASE_RECENT_WEIGHT * (durations[i] - phase->recent);
+		phase->calls++;
+		phase->total += durations[i];
+		phase->max = Max(phase->max, durations[i]);
+		phase->last = durations[i];
+	}
+	LWLockRelease(ticker_state->lock);
+}
+
+/*
+ * Count a failed tick.
+ */
+void
+ticker_worker_count_tick_error(void)
+{
+	if (MyTickerWorker == NULL)
+		return;
+
+	LWLockAcquire(ticker_state->lock, LW_EXCLUSIVE);
+	MyTickerWorker->tick_errors++;
+	LWLockRelease(ticker_state->lock);
+}
+
+/*
+ * Are there tick_now() requests this worker has not served yet?
+ */
+bool
+ticker_worker_tick_requested(void)
+{
+	bool		requested;
+
+	if (MyTickerWorker == NULL)
+		return false;
+
+	LWLockAcquire(ticker_state->lock, LW_SHARED);
+	requested = MyTickerWorker->tick_requests > MyTickerWorker->tick_requests_served;
+	LWLockRelease(ticker_state->lock);
+
+	return requested;
+}
+
+/*
+ * Take the tick_now() requests made so far for the given sets: set
+ * requested[i] for each entry a request is pending for, and clear it.
+ * Returns the number of requests taken, to be passed on to
+ * ticker_worker_serve_tick_requests() once the tick has committed.
+ */
+int64
+ticker_worker_take_tick_requests(TickerSetStatus **entries, int nentries,
+								 bool *requested)
+{
+	int64		taken;
+	int			i;
+
+	if (MyTickerWorker == NULL)
+		return 0;
+
+	LWLockAcquire(ticker_state->lock, LW_EXCLUSIVE);
+	taken = MyTickerWorker->tick_requests;
+	for (i = 0; i < nentries; i++)
+	{
+		if (entries[i] == NULL || !entries[i]->tick_requested)
+			continue;
+
+		requested[i] = true;
+		entries[i]->tick_requested = false;
+	}
+	LWLockRelease(ticker_state->lock);
+
+	return taken;
+}
+
+/*
+ * The tick which took the first served tick_now() requests has committed.
+ */
+void
+ticker_worker_serve_tick_requests(int64 served, TimestampTz tick_time,
+								  TimestampTz commit_time, XLogRecPtr commit_lsn)
+{
+	if (MyTickerWorker == NULL)
+		return;
+
+	LWLockAcquire(ticker_state->lock, LW_EXCLUSIVE);
+	if (served > MyTickerWorker->tick_requests_served)
+	{
+		MyTickerWorker->tick_requests_served = served;
+		MyTickerWorker->served_tick_time = tick_time;
+		MyTickerWorker->served_commit_time = commit_time;
+		MyTickerWorker->served_commit_lsn = commit_lsn;
+	}
+	LWLockRelease(ticker_state->lock);
+}
+
+/*
+ * Find or create the status entry of a replication set of a database.
+ * Existing entries keep their values, so counters survive worker restarts.
+ * Returns NULL if pglogical_ticker.max_tracked_sets is exhausted.
+ */
+TickerSetStatus *
+ticker_status_enter(Oid dbid, const char *set_name)
+{
+	TickerSetStatusKey key;
+	TickerSetStatus *entry;
+	bool		found;
+
+	if (ticker_state == NULL)
+		return NULL;
+
+	memset(&key, 0, sizeof(key));
+	key.dbid = dbid;
+	namestrcpy(&key.set_name, set_name);
+
+	LWLockAcquire(ticker_state->lock, LW_EXCLUSIVE);
+	entry = (TickerSetStatus *) hash_search(ticker_status_hash, &key,
+											HASH_FIND, &found);
+	if (entry == NULL &&
+		hash_get_num_entries(ticker_status_hash) < pglogical_ticker_max_tracked_sets)
+		entry = (TickerSetStatus *) hash_search(ticker_status_hash, &key,
+												HASH_ENTER_NULL, &found);
+	if (entry != NULL && !found)
+	{
+		entry->worker_pid = MyProcPid;
+		entry->last_tick_time = 0;
+		entry->last_tick_duration = 0;
+		entry->last_commit_lsn = InvalidXLogRecPtr;
+		entry->consecutive_errors = 0;
+		entry->tick_requested = false;
+	}
+	LWLockRelease(ticker_state->lock);
+
+	if (entry == NULL)
+		ereport(WARNING,
+				(errmsg("pglogical_ticker: cannot track status of replication set \"%s\"",
+						set_name),
+				 errhint("Increase pglogical_ticker.max_tracked_sets.")));
+
+	return entry;
+}
+
+static int
+ticker_status_ptr_cmp(const void *a, const void *b)
+{
+	const TickerSetStatus *pa = *(TickerSetStatus *const *) a;
+	const TickerSetStatus *pb = *(TickerSetStatus *const *) b;
+
+	if (pa < pb)
+		return -1;
+	if (pa > pb)
+		return 1;
+	return 0;
+}
+
+/*
+ * Remove the entries of a database that are not in the keep array.
+ * NULL members of keep are ignored.
+ */
+void
+ticker_status_prune(Oid dbid, TickerSetStatus **keep, int nkeep)
+{
+	HASH_SEQ_STATUS status;
+	TickerSetStatus *entry;
+	TickerSetStatus **sorted;
+
+	if (ticker_state == NULL)
+		return;
+
+	sorted = (TickerSetStatus **) palloc(Max(nkeep, 1) * sizeof(TickerSetStatus *));
+	memcpy(sorted, keep, nkeep * sizeof(TickerSetStatus *));
+	qsort(sorted, nkeep, sizeof(TickerSetStatus *), ticker_status_ptr_cmp);
+
+	LWLockAcquire(ticker_state->lock, LW_EXCLUSIVE);
+	hash_seq_init(&status, ticker_status_hash);
+	while ((entry = (TickerSetStatus *) hash_seq_search(&status)) != NULL)
+	{
+		if (entry->key.dbid != dbid)
+			continue;
+		if (bsearch(&entry, sorted, nkeep, sizeof(TickerSetStatus *),
+					ticker_status_ptr_cmp) != NULL)
+			continue;
+
+		/* deleting the element just returned by hash_seq_search is allowed */
+		hash_search(ticker_status_hash, &entry->key, HASH_REMOVE, NULL);
+	}
+	LWLockRelease(ticker_state->lock);
+
+	pfree(sorted);
+}
+
+/*
+ * Record a successful tick of the given sets, each at the interval of its
+ * tick group.
+ */
+void
+ticker_status_report(TickerSetStatus **entries, int64 *intervals,
+					 int nentries,
+					 TimestampTz tick_time, int64 duration,
+					 XLogRecPtr commit_lsn)
+{
+	int			i;
+
+	if (ticker_state == NULL)
+		return;
+
+	LWLockAcquire(ticker_state->lock, LW_EXCLUSIVE);
+	for (i = 0; i < nentries; i++)
+	{
+		TickerSetStatus *entry = entries[i];
+
+		if (entry == NULL)
+			continue;
+
+		entry->worker_pid = MyProcPid;
+		entry->last_tick_time = tick_time;
+		entry->last_tick_duration = duration;
+		if (!XLogRecPtrIsInvalid(commit_lsn))
+			entry->last_commit_lsn = commit_lsn;
+		entry->consecutive_errors = 0;
+		entry->tick_interval = intervals[i];
+	}
+	LWLockRelease(ticker_state->lock);
+}
+
+/*
+ * Record a failed tick of the given sets.
+ */
+void
+ticker_status_report_error(TickerSetStatus **entries, int nentries)
+{
+	int			i;
+
+	if (ticker_state == NULL)
+		return;
+
+	LWLockAcquire(ticker_state->lock, LW_EXCLUSIVE);
+	for (i = 0; i < nentries; i++)
+	{
+		TickerSetStatus *entry = entries[i];
+
+		if (entry == NULL)
+			continue;
+
+		entry->worker_pid = MyProcPid;
+		entry->consecutive_errors++;
+	}
+	LWLockRelease(ticker_state->lock);
+}
+
+static int
+ticker_lag_bucket(int64 lag)
+{
+	int			bucket;
+
+	if (lag < 1000)
+		return 0;
+
+	bucket = 1 + (int) floor(log2(lag / 1000.0) * TICKER_LAG_BUCKETS_PER_DOUBLING);
+
+	return Min(bucket, TICKER_LAG_BUCKETS - 1);
+}
+
+/* Upper bound of the lags in a bucket, in microseconds */
+static double
+ticker_lag_bucket_bound(int bucket)
+{
+	return 1000.0 * pow(2.0, (double) bucket / TICKER_LAG_BUCKETS_PER_DOUBLING);
+}
+
+/*
+ * Add a lag sample, in microseconds, to the histogram of a provider and
+ * replication set of a database.  Samples of new pairs are dropped once
+ * pglogical_ticker.max_tracked_sets histograms exist.
+ */
+void
+ticker_lag_record(Oid dbid, Name provider_name, Name set_name, int64 lag)
+{
+	TickerLagKey key;
+	TickerLagHistogram *hist;
+	bool		found;
+
+	if (ticker_state == NULL)
+		return;
+
+	memset(&key, 0, sizeof(key));
+	key.dbid = dbid;
+	namestrcpy(&key.provider_name, NameStr(*provider_name));
+	namestrcpy(&key.set_name, NameStr(*set_name));
+
+	LWLockAcquire(ticker_state->lock, LW_EXCLUSIVE);
+	hist = (TickerLagHistogram *) hash_search(ticker_lag_hash, &key,
+											  HASH_FIND, &found);
+	if (hist == NULL &&
+		hash_get_num_entries(ticker_lag_hash) < pglogical_ticker_max_tracked_sets)
+		hist = (TickerLagHistogram *) hash_search(ticker_lag_hash, &key,
+												  HASH_ENTER_NULL, &found);
+	if (hist != NULL)
+	{
+		if (!found)
+		{
+			memset((char *) hist + sizeof(TickerLagKey), 0,
+				   sizeof(TickerLagHistogram) - sizeof(TickerLagKey));
+			hist->since = GetCurrentTimestamp();
+		}
+		hist->samples++;
+		hist->max_lag = Max(hist->max_lag, lag);
+		hist->buckets[ticker_lag_bucket(lag)]++;
+	}
+	LWLockRelease(ticker_state->lock);
+}
+
+/*
+ * The given percentile of a histogram in milliseconds: the upper bound of
+ * the bucket it falls in, but no more than the largest sample.
+ */
+static double
+ticker_lag_percentile(TickerLagHistogram *hist, double fraction)
+{
+	int64		rank = (int64) ceil(fraction * hist->samples);
+	int64		seen = 0;
+	int			bucket;
+
+	for (bucket = 0; bucket < TICKER_LAG_BUCKETS - 1; bucket++)
+	{
+		seen += hist->buckets[bucket];
+		if (seen >= rank)
+			break;
+	}
+
+	return Min(ticker_lag_bucket_bound(bucket), (double) hist->max_lag) / 1000.0;
+}
+
+/*
+ * Log an applied tick.  This runs in the apply trigger of every ticker
+ * table, so it takes no lock and allocates nothing.
+ */
+void
+ticker_apply_record(Oid dbid, Name provider_name, Name set_name,
+					TimestampTz source_time, TimestampTz apply_time)
+{
+	uint64		pos;
+	TickerApplyEvent *event;
+
+	if (ticker_apply_ring == NULL)
+		return;
+
+	pos = pg_atomic_fetch_add_u64(&ticker_apply_ring->next, 1);
+	event = &ticker_apply_ring->events[pos % ticker_apply_ring->size];
+
+	pg_atomic_write_u64(&event->seq, 0);
+	pg_write_barrier();
+
+	event->dbid = dbid;
+	memcpy(&event->provider_name, provider_name, sizeof(NameData));
+	memcpy(&event->set_name, set_name, sizeof(NameData));
+	event->source_time = source_time;
+	event->apply_time = apply_time;
+
+	pg_write_barrier();
+	pg_atomic_write_u64(&event->seq, pos + 1);
+}
+
+/*
+ * SQL function pglogical_ticker.worker_status()
+ *		Status of every replication set ticked by a worker.
+ */
+Datum
+pglogical_ticker_worker_status(PG_FUNCTION_ARGS)
+{
+	TupleDesc	tupdesc;
+	Tuplestorestate *tupstore;
+	HASH_SEQ_STATUS status;
+	TickerSetStatus *entry;
+	TickerSetStatus *entries;
+	int			nentries = 0;
+	int			i;
+
+	ticker_shmem_require();
+
+	tupstore = ticker_materialized_srf(fcinfo, &tupdesc);
+
+	/* Copy the entries first, so the lock is not held across catalog lookups */
+	entries = (TickerSetStatus *)
+		palloc(sizeof(TickerSetStatus) * pglogical_ticker_max_tracked_sets);
+
+	LWLockAcquire(ticker_state->lock, LW_SHARED);
+	hash_seq_init(&status, ticker_status_hash);
+	while ((entry = (TickerSetStatus *) hash_seq_search(&status)) != NULL)
+	{
+		if (nentries >= pglogical_ticker_max_tracked_sets)
+		{
+			hash_seq_term(&status);
+			break;
+		}
+		entries[nentries++] = *entry;
+	}
+	LWLockRelease(ticker_state->lock);
+
+	for (i = 0; i < nentries; i++)
+	{
+		Datum		values[8];
+		bool		nulls[8];
+		char	   *dbname;
+
+		entry = &entries[i];
+		memset(nulls, 0, sizeof(nulls));
+
+		dbname = get_database_name(entry->key.dbid);
+		if (dbname == NULL)
+			continue;
+
+		values[0] = DirectFunctionCall1(namein, CStringGetDatum(dbname));
+		values[1] = NameGetDatum(&entry->key.set_name);
+		values[2] = Int32GetDatum(entry->worker_pid);
+		if (entry->last_tick_time != 0)
+		{
+			values[3] = TimestampTzGetDatum(entry->last_tick_time);
+			values[4] = Float8GetDatum(entry->last_tick_duration / 1000.0);
+		}
+		else
+		{
+			nulls[3] = true;
+			nulls[4] = true;
+		}
+		if (!XLogRecPtrIsInvalid(entry->last_commit_lsn))
+			values[5] = LSNGetDatum(entry->last_commit_lsn);
+		else
+			nulls[5] = true;
+		values[6] = Int64GetDatum(entry->consecutive_errors);
+		if (entry->tick_interval != 0)
+			values[7] = Float8GetDatum(entry->tick_interval / 1000.0);
+		else
+			nulls[7] = true;
+
+		tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+	}
+
+	pfree(entries);
+
+	return (Datum) 0;
+}
+
+/*
+ * SQL function pglogical_ticker.worker_stats()
+ *		Scheduling counters of every ticker worker.
+ */
+Datum
+pglogical_ticker_worker_stats(PG_FUNCTION_ARGS)
+{
+	TupleDesc	tupdesc;
+	Tuplestorestate *tupstore;
+	TickerWorkerStatus *workers;
+	int			nworkers;
+	int			i;
+
+	ticker_shmem_require();
+
+	tupstore = ticker_materialized_srf(fcinfo, &tupdesc);
+
+	nworkers = ticker_state->nworkers;
+	workers = (TickerWorkerStatus *) palloc(sizeof(TickerWorkerStatus) * nworkers);
+
+	LWLockAcquire(ticker_state->lock, LW_SHARED);
+	memcpy(workers, ticker_state->workers, sizeof(TickerWorkerStatus) * nworkers);
+	LWLockRelease(ticker_state->lock);
+
+	for (i = 0; i < nworkers; i++)
+	{
+		TickerWorkerStatus *w = &workers[i];
+		Datum		values[6];
+		bool		nulls[6];
+		char	   *dbname;
+
+		if (w->dbid == InvalidOid || w->extension_missing)
+			continue;
+
+		dbname = get_database_name(w->dbid);
+		if (dbname == NULL)
+			continue;
+
+		memset(nulls, 0, sizeof(nulls));
+		values[0] = DirectFunctionCall1(namein, CStringGetDatum(dbname));
+		if (w->pid != 0)
+			values[1] = Int32GetDatum(w->pid);
+		else
+			nulls[1] = true;
+		values[2] = Float8GetDatum(w->interval / 1000.0);
+		values[3] = Int64GetDatum(w->ticks);
+		values[4] = Int64GetDatum(w->late_ticks);
+		values[5] = Int64GetDatum(w->missed_ticks);
+
+		tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+	}
+
+	pfree(workers);
+
+	return (Datum) 0;
+}
+
+/*
+ * SQL function pglogical_ticker.tick_phase_stats()
+ *		Time spent by every ticker worker in each phase of its ticks.
+ */
+Datum
+pglogical_ticker_tick_phase_stats(PG_FUNCTION_ARGS)
+{
+	TupleDesc	tupdesc;
+	Tuplestorestate *tupstore;
+	TickerWorkerStatus *workers;
+	int			nworkers;
+	int			i;
+	int			p;
+
+	ticker_shmem_require();
+
+	tupstore = ticker_materialized_srf(fcinfo, &tupdesc);
+
+	nworkers = ticker_state->nworkers;
+	workers = (TickerWorkerStatus *) palloc(sizeof(TickerWorkerStatus) * nworkers);
+
+	LWLockAcquire(ticker_state->lock, LW_SHARED);
+	memcpy(workers, ticker_state->workers, sizeof(TickerWorkerStatus) * nworkers);
+	LWLockRelease(ticker_state->lock);
+
+	for (i = 0; i < nworkers; i++)
+	{
+		TickerWorkerStatus *w = &workers[i];
+		char	   *dbname;
+
+		if (w->dbid == InvalidOid || w->extension_missing)
+			continue;
+
+		dbname = get_database_name(w->dbid);
+		if (dbname == NULL)
+			continue;
+
+		for (p = 0; p < TICKER_NUM_PHASES; p++)
+		{
+			TickerPhaseStats *phase = &w->phases[p];
+			Datum		values[8];
+			bool		nulls[8];
+
+			memset(nulls, 0, sizeof(nulls));
+			values[0] = DirectFunctionCall1(namein, CStringGetDatum(dbname));
+			values[1] = CStringGetTextDatum(ticker_phase_names[p]);
+			values[2] = Int64GetDatum(phase->calls);
+			values[3] = Float8GetDatum(phase->total / 1000.0);
+			if (phase->calls > 0)
+			{
+				values[4] = Float8GetDatum(phase->total / 1000.0 / phase->calls);
+				values[5] = Float8GetDatum(phase->recent / 1000.0);
+				values[6] = Float8GetDatum(phase->max / 1000.0);
+				values[7] = Float8GetDatum(phase->last / 1000.0);
+			}
+			else
+			{
+				nulls[4] = true;
+				nulls[5] = true;
+				nulls[6] = true;
+				nulls[7] = true;
+			}
+
+			tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+		}
+	}
+
+	pfree(workers);
+
+	return (Datum) 0;
+}
+
+/*
+ * SQL function pglogical_ticker.tick_commits()
+ *		Time and commit LSN of the last ticks of every ticker worker, oldest
+ *		first.
+ */
+Datum
+pglogical_ticker_tick_commits(PG_FUNCTION_ARGS)
+{
+	TupleDesc	tupdesc;
+	Tuplestorestate *tupstore;
+	TickerWorkerStatus *workers;
+	int			nworkers;
+	int			i;
+
+	ticker_shmem_require();
+
+	tupstore = ticker_materialized_srf(fcinfo, &tupdesc);
+
+	nworkers = ticker_state->nworkers;
+	workers = (TickerWorkerStatus *) palloc(sizeof(TickerWorkerStatus) * nworkers);
+
+	LWLockAcquire(ticker_state->lock, LW_SHARED);
+	memcpy(workers, ticker_state->workers, sizeof(TickerWorkerStatus) * nworkers);
+	LWLockRelease(ticker_state->lock);
+
+	for (i = 0; i < nworkers; i++)
+	{
+		TickerWorkerStatus *w = &workers[i];
+		char	   *dbname;
+		int64		pos;
+
+		if (w->dbid == InvalidOid || w->extension_missing)
+			continue;
+
+		dbname = get_database_name(w->dbid);
+		if (dbname == NULL)
+			continue;
+
+		for (pos = Max(w->ncommits - TICKER_COMMIT_HISTORY, 0); pos < w->ncommits; pos++)
+		{
+			TickerCommit *commit = &w->commits[pos % TICKER_COMMIT_HISTORY];
+			Datum		values[3];
+			bool		nulls[3];
+
+			memset(nulls, 0, sizeof(nulls));
+			values[0] = DirectFunctionCall1(namein, CStringGetDatum(dbname));
+			values[1] = TimestampTzGetDatum(commit->tick_time);
+			values[2] = LSNGetDatum(commit->commit_lsn);
+
+			tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+		}
+	}
+
+	pfree(workers);
+
+	return (Datum) 0;
+}
+
+/*
+ * SQL function pglogical_ticker.tick_now(set_names)
+ *		Have the worker of this database tick the given replication sets
+ *		right away, and wait for the tick to commit.  Returns the source_time
+ *		the tick wrote, which is the start time of its transaction, and the
+ *		timestamp and LSN of its commit record.
+ *
+ * The sets are flagged in their status entries, and the worker is woken by
+ * its latch.  It ticks them, along with the other sets of their tick group,
+ * in its next transaction, and then records how many requests that served.
+ * Requests made together are served by a single tick.
+ */
+Datum
+pglogical_ticker_tick_now(PG_FUNCTION_ARGS)
+{
+	ArrayType  *set_names = PG_GETARG_ARRAYTYPE_P(0);
+	TupleDesc	tupdesc;
+	Tuplestorestate *tupstore;
+	Datum	   *elems;
+	bool	   *elem_nulls;
+	int			nelems;
+	TickerWorkerStatus *slot = NULL;
+	TickerSetStatus **entries;
+	const char *missing = NULL;
+	int			pid = 0;
+	Latch	   *latch = NULL;
+	int64		request = 0;
+	TimestampTz served_tick_time = 0;
+	TimestampTz served_commit_time = 0;
+	XLogRecPtr	served_commit_lsn = InvalidXLogRecPtr;
+	Datum		values[3];
+	bool		nulls[3];
+	int			i;
+
+	ticker_shmem_require();
+
+	tupstore = ticker_materialized_srf(fcinfo, &tupdesc);
+
+	deconstruct_array(set_names, NAMEOID, NAMEDATALEN, false, 'c',
+					  &elems, &elem_nulls, &nelems);
+	for (i = 0; i < nelems; i++)
+	{
+		if (elem_nulls[i])
+			ereport(ERROR,
+					(errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED),
+					 errmsg("replication set names must not be null")));
+	}
+	entries = (TickerSetStatus **) palloc(Max(nelems, 1) * sizeof(TickerSetStatus *));
+
+	LWLockAcquire(ticker_state->lock, LW_EXCLUSIVE);
+	for (i = 0; i < ticker_state->nworkers; i++)
+	{
+		TickerWorkerStatus *w = &ticker_state->workers[i];
+
+		if (w->dbid == MyDatabaseId && w->pid != 0 && w->latch != NULL)
+		{
+			slot = w;
+			break;
+		}
+	}
+	for (i = 0; slot != NULL && i < nelems; i++)
+	{
+		TickerSetStatusKey key;
+
+		memset(&key, 0, sizeof(key));
+		key.dbid = MyDatabaseId;
+		namestrcpy(&key.set_name, NameStr(*DatumGetName(elems[i])));
+		entries[i] = (TickerSetStatus *) hash_search(ticker_status_hash, &key,
+													 HASH_FIND, NULL);
+		if (entries[i] == NULL)
+		{
+			missing = NameStr(*DatumGetName(elems[i]));
+			break;
+		}
+	}
+	if (slot != NULL && missing == NULL)
+	{
+		for (i = 0; i < nelems; i++)
+			entries[i]->tick_requested = true;
+		request = ++slot->tick_requests;
+		pid = slot->pid;
+		latch = slot->latch;
+	}
+	LWLockRelease(ticker_state->lock);
+
+	if (slot == NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("no pglogical_ticker worker is running in this database")));
+	if (missing != NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_UNDEFINED_OBJECT),
+				 errmsg("replication set \"%s\" is not ticked by the pglogical_ticker worker",
+						missing),
+				 errhint("Deploy its ticker table, or wait for the worker to pick it up.")));
+
+	SetLatch(latch);
+
+	for (;;)
+	{
+		bool		done;
+		bool		gone;
+		int			rc;
+
+		LWLockAcquire(ticker_state->lock, LW_SHARED);
+		done = slot->tick_requests_served >= request;
+		gone = slot->pid != pid;
+		served_tick_time = slot->served_tick_time;
+		served_commit_time = slot->served_commit_time;
+		served_commit_lsn = slot->served_commit_lsn;
+		LWLockRelease(ticker_state->lock);
+
+		if (done)
+			break;
+		if (gone)
+			ereport(ERROR,
+					(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+					 errmsg("pglogical_ticker worker exited before ticking"),
+					 errhint("See the server log for the reason.")));
+
+#if PG_VERSION_NUM >= 100000
+		rc = WaitLatch(MyLatch,
+					   WL_LATCH_SET | WL_TIMEOUT | WL_POSTMASTER_DEATH,
+					   10L, PG_WAIT_EXTENSION);
+#else
+		rc = WaitLatch(MyLatch,
+					   WL_LATCH_SET | WL_TIMEOUT | WL_POSTMASTER_DEATH,
+					   10L);
+#endif
+		ResetLatch(MyLatch);
+
+		if (rc & WL_POSTMASTER_DEATH)
+			ereport(FATAL,
+					(errcode(ERRCODE_ADMIN_SHUTDOWN),
+					 errmsg("terminating connection due to unexpected postmaster exit")));
+
+		CHECK_FOR_INTERRUPTS();
+	}
+
+	memset(nulls, 0, sizeof(nulls));
+	values[0] = TimestampTzGetDatum(served_tick_time);
+	values[1] = TimestampTzGetDatum(served_commit_time);
+	values[2] = LSNGetDatum(served_commit_lsn);
+	if (XLogRecPtrIsInvalid(served_commit_lsn))
+		nulls[1] = nulls[2] = true;
+	tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+
+	pfree(entries);
+
+	return (Datum) 0;
+}
+
+/*
+ * SQL function pglogical_ticker.lag_histogram()
+ *		Lag percentiles of every provider and replication set sampled by a
+ *		worker since the histogram was last reset.
+ */
+Datum
+pglogical_ticker_lag_histogram(PG_FUNCTION_ARGS)
+{
+	TupleDesc	tupdesc;
+	Tuplestorestate *tupstore;
+	HASH_SEQ_STATUS status;
+	TickerLagHistogram *hist;
+	TickerLagHistogram *hists;
+	int			nhists = 0;
+	int			i;
+
+	ticker_shmem_require();
+
+	tupstore = ticker_materialized_srf(fcinfo, &tupdesc);
+
+	/* Copy the histograms first, so the lock is not held across catalog lookups */
+	hists = (TickerLagHistogram *)
+		palloc(sizeof(TickerLagHistogram) * pglogical_ticker_max_tracked_sets);
+
+	LWLockAcquire(ticker_state->lock, LW_SHARED);
+	hash_seq_init(&status, ticker_lag_hash);
+	while ((hist = (TickerLagHistogram *) hash_seq_search(&status)) != NULL)
+	{
+		if (nhists >= pglogical_ticker_max_tracked_sets)
+		{
+			hash_seq_term(&status);
+			break;
+		}
+		hists[nhists++] = *hist;
+	}
+	LWLockRelease(ticker_state->lock);
+
+	for (i = 0; i < nhists; i++)
+	{
+		Datum		values[9];
+		bool		nulls[9];
+		char	   *dbname;
+
+		hist = &hists[i];
+		memset(nulls, 0, sizeof(nulls));
+
+		dbname = get_database_name(hist->key.dbid);
+		if (dbname == NULL)
+			continue;
+
+		values[0] = DirectFunctionCall1(namein, CStringGetDatum(dbname));
+		values[1] = NameGetDatum(&hist->key.provider_name);
+		values[2] = NameGetDatum(&hist->key.set_name);
+		values[3] = TimestampTzGetDatum(hist->since);
+		values[4] = Int64GetDatum(hist->samples);
+		values[5] = Float8GetDatum(ticker_lag_percentile(hist, 0.5));
+		values[6] = Float8GetDatum(ticker_lag_percentile(hist, 0.9));
+		values[7] = Float8GetDatum(ticker_lag_percentile(hist, 0.99));
+		values[8] = Float8GetDatum(hist->max_lag / 1000.0);
+
+		tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+	}
+
+	pfree(hists);
+
+	return (Datum) 0;
+}
+
+/*
+ * SQL function pglogical_ticker.lag_histogram_reset(name)
+ *		Start a new window for the lag histograms of the current database,
+ *		or only those of the given replication set.
+ */
+Datum
+pglogical_ticker_lag_histogram_reset(PG_FUNCTION_ARGS)
+{
+	HASH_SEQ_STATUS status;
+	TickerLagHistogram *hist;
+	Name		set_name = PG_ARGISNULL(0) ? NULL : PG_GETARG_NAME(0);
+
+	ticker_shmem_require();
+
+	/* Dropping the histograms also forgets sets which are gone */
+	LWLockAcquire(ticker_state->lock, LW_EXCLUSIVE);
+	hash_seq_init(&status, ticker_lag_hash);
+	while ((hist = (TickerLagHistogram *) hash_seq_search(&status)) != NULL)
+	{
+		if (hist->key.dbid != MyDatabaseId)
+			continue;
+		if (set_name != NULL &&
+			strcmp(NameStr(hist->key.set_name), NameStr(*set_name)) != 0)
+			continue;
+
+		/* deleting the element just returned by hash_seq_search is allowed */
+		hash_search(ticker_lag_hash, &hist->key, HASH_REMOVE, NULL);
+	}
+	LWLockRelease(ticker_state->lock);
+
+	PG_RETURN_VOID();
+}
+
+/*
+ * SQL function pglogical_ticker.apply_events()
+ *		Ticks logged by the apply trigger, oldest first.
+ */
+Datum
+pglogical_ticker_apply_events(PG_FUNCTION_ARGS)
+{
+	TupleDesc	tupdesc;
+	Tuplestorestate *tupstore;
+	uint64		next;
+	uint64		pos;
+
+	ticker_shmem_require();
+
+	tupstore = ticker_materialized_srf(fcinfo, &tupdesc);
+
+	next = pg_atomic_read_u64(&ticker_apply_ring->next);
+	pos = next > (uint64) ticker_apply_ring->size ?
+		next - ticker_apply_ring->size : 0;
+
+	for (; pos < next; pos++)
+	{
+		TickerApplyEvent *event;
+		TickerApplyEvent copy;
+		Datum		values[6];
+		bool		nulls[6];
+		char	   *dbname;
+
+		event = &ticker_apply_ring->events[pos % ticker_apply_ring->size];
+
+		/* Skip events being written, or overwritten while we copy them */
+		if (pg_atomic_read_u64(&event->seq) != pos + 1)
+			continue;
+		pg_read_barrier();
+		copy.dbid = event->dbid;
+		copy.provider_name = event->provider_name;
+		copy.set_name = event->set_name;
+		copy.source_time = event->source_time;
+		copy.apply_time = event->apply_time;
+		pg_read_barrier();
+		if (pg_atomic_read_u64(&event->seq) != pos + 1)
+			continue;
+
+		dbname = get_database_name(copy.dbid);
+		if (dbname == NULL)
+			continue;
+
+		memset(nulls, 0, sizeof(nulls));
+		values[0] = DirectFunctionCall1(namein, CStringGetDatum(dbname));
+		values[1] = NameGetDatum(&copy.provider_name);
+		values[2] = NameGetDatum(&copy.set_name);
+		values[3] = TimestampTzGetDatum(copy.source_time);
+		values[4] = TimestampTzGetDatum(copy.apply_time);
+		values[5] = DirectFunctionCall2(timestamp_mi,
+										TimestampTzGetDatum(copy.apply_time),
+										TimestampTzGetDatum(copy.source_time));
+
+		tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+	}
+
+	return (Datum) 0;
+}
+
+/*
+ * Append a label value, escaped as the Prometheus text format requires.
+ */
+static void
+ticker_metrics_label(StringInfo buf, const char *value)
+{
+	const char *p;
+
+	for (p = value; *p; p++)
+	{
+		if (*p == '\\' || *p == '"')
+			appendStringInfoChar(buf, '\\');
+		if (*p == '\n')
+			appendStringInfoString(buf, "\\n");
+		else
+			appendStringInfoChar(buf, *p);
+	}
+}
+
+static void
+ticker_metrics_header(StringInfo buf, const char *name, const char *type,
+					  const char *help)
+{
+	appendStringInfo(buf, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+/* Append the start of a sample of a worker, up to its labels */
+static void
+ticker_metrics_worker(StringInfo buf, const char *name, const char *dbname)
+{
+	appendStringInfo(buf, "%s{datname=\"", name);
+	ticker_metrics_label(buf, dbname);
+	appendStringInfoChar(buf, '"');
+}
+
+/*
+ * Append a counter of every worker, read from the int64 at the given offset
+ * of TickerWorkerStatus.
+ */
+static void
+ticker_metrics_worker_counter(StringInfo buf, const char *name, const char *help,
+							  TickerWorkerStatus *workers, char **dbnames,
+							  int nworkers, Size offset)
+{
+	int			i;
+
+	ticker_metrics_header(buf, name, "counter", help);
+	for (i = 0; i < nworkers; i++)
+	{
+		if (dbnames[i] == NULL)
+			continue;
+		ticker_metrics_worker(buf, name, dbnames[i]);
+		appendStringInfo(buf, "} " INT64_FORMAT "\n",
+						 *(int64 *) ((char *) &workers[i] + offset));
+	}
+}
+
+/*
+ * SQL function pglogical_ticker.metrics()
+ *		Worker and replication set counters, in the Prometheus text
+ *		exposition format.
+ *
+ * Everything comes from shared memory, so the cost of a scrape does not
+ * depend on the number of tables or replication sets.
+ */
+Datum
+pglogical_ticker_metrics(PG_FUNCTION_ARGS)
+{
+	StringInfoData buf;
+	TickerWorkerStatus *workers;
+	char	  **dbnames;
+	int			nworkers;
+	HASH_SEQ_STATUS status;
+	TickerSetStatus *entry;
+	TickerSetStatus *entries;
+	int			nentries = 0;
+	TimestampTz now = GetCurrentTimestamp();
+	int			i;
+	int			b;
+
+	ticker_shmem_require();
+
+	/* Copy everything first, so the lock is not held across catalog lookups */
+	nworkers = ticker_state->nworkers;
+	workers = (TickerWorkerStatus *) palloc(sizeof(TickerWorkerStatus) * nworkers);
+	entries = (TickerSetStatus *)
+		palloc(sizeof(TickerSetStatus) * pglogical_ticker_max_tracked_sets);
+
+	LWLockAcquire(ticker_state->lock, LW_SHARED);
+	memcpy(workers, ticker_state->workers, sizeof(TickerWorkerStatus) * nworkers);
+	hash_seq_init(&status, ticker_status_hash);
+	while ((entry = (TickerSetStatus *) hash_seq_search(&status)) != NULL)
+	{
+		if (nentries >= pglogical_ticker_max_tracked_sets)
+		{
+			hash_seq_term(&status);
+			break;
+		}
+		entries[nentries++] = *entry;
+	}
+	LWLockRelease(ticker_state->lock);
+
+	/* NULL for the slots not to report */
+	dbnames = (char **) palloc(sizeof(char *) * nworkers);
+	for (i = 0; i < nworkers; i++)
+	{
+		if (workers[i].dbid == InvalidOid || workers[i].extension_missing)
+			dbnames[i] = NULL;
+		else
+			dbnames[i] = get_database_name(workers[i].dbid);
+	}
+
+	initStringInfo(&buf);
+
+	ticker_metrics_header(&buf, "pglogical_ticker_worker_up", "gauge",
+						  "Whether the ticker worker of the database is running.");
+	for (i = 0; i < nworkers; i++)
+	{
+		if (dbnames[i] == NULL)
+			continue;
+		ticker_metrics_worker(&buf, "pglogical_ticker_worker_up", dbnames[i]);
+		appendStringInfo(&buf, "} %d\n", workers[i].pid != 0 ? 1 : 0);
+	}
+
+	ticker_metrics_header(&buf, "pglogical_ticker_worker_restarts_total", "counter",
+						  "Ticker workers started for the database after the first one.");
+	for (i = 0; i < nworkers; i++)
+	{
+		if (dbnames[i] == NULL)
+			continue;
+		ticker_metrics_worker(&buf, "pglogical_ticker_worker_restarts_total", dbnames[i]);
+		appendStringInfo(&buf, "} " INT64_FORMAT "\n", Max(workers[i].starts - 1, 0));
+	}
+
+	ticker_metrics_header(&buf, "pglogical_ticker_tick_interval_seconds", "gauge",
+						  "Default tick interval of the worker.");
+	for (i = 0; i < nworkers; i++)
+	{
+		if (dbnames[i] == NULL)
+			continue;
+		ticker_metrics_worker(&buf, "pglogical_ticker_tick_interval_seconds", dbnames[i]);
+		appendStringInfo(&buf, "} %g\n", workers[i].interval / 1000000.0);
+	}
+
+	ticker_metrics_worker_counter(&buf, "pglogical_ticker_ticks_total",
+								  "Ticks fired by the worker.",
+								  workers, dbnames, nworkers,
+								  offsetof(TickerWorkerStatus, ticks));
+
+	ticker_metrics_worker_counter(&buf, "pglogical_ticker_late_ticks_total",
+								  "Ticks fired more than a tenth of the interval late.",
+								  workers, dbnames, nworkers,
+								  offsetof(TickerWorkerStatus, late_ticks));
+
+	ticker_metrics_worker_counter(&buf, "pglogical_ticker_missed_ticks_total",
+								  "Tick deadlines skipped by the worker.",
+								  workers, dbnames, nworkers,
+								  offsetof(TickerWorkerStatus, missed_ticks));
+
+	ticker_metrics_worker_counter(&buf, "pglogical_ticker_tick_errors_total",
+								  "Ticks that failed.",
+								  workers, dbnames, nworkers,
+								  offsetof(TickerWorkerStatus, tick_errors));
+
+	ticker_metrics_header(&buf, "pglogical_ticker_tick_duration_seconds", "histogram",
+						  "Duration of the successful ticks.");
+	for (i = 0; i < nworkers; i++)
+	{
+		int64		count = 0;
+
+		if (dbnames[i] == NULL)
+			continue;
+		for (b = 0; b < TICKER_TICK_DURATION_BUCKETS; b++)
+		{
+			count += workers[i].tick_durations[b];
+			ticker_metrics_worker(&buf, "pglogical_ticker_tick_duration_seconds_bucket",
+								  dbnames[i]);
+			if (b < TICKER_TICK_DURATION_BUCKETS - 1)
+				appendStringInfo(&buf, ",le=\"%g\"} " INT64_FORMAT "\n",
+								 ticker_tick_duration_bounds[b] / 1000000.0, count);
+			else
+				appendStringInfo(&buf, ",le=\"+Inf\"} " INT64_FORMAT "\n", count);
+		}
+		ticker_metrics_worker(&buf, "pglogical_ticker_tick_duration_seconds_sum",
+							  dbnames[i]);
+		appendStringInfo(&buf, "} %.6f\n", workers[i].tick_duration_sum / 1000000.0);
+		ticker_metrics_worker(&buf, "pglogical_ticker_tick_duration_seconds_count",
+							  dbnames[i]);
+		appendStringInfo(&buf, "} " INT64_FORMAT "\n", count);
+	}
+
+	/* Now per replication set, for the sets ticked at least once */
+	ticker_metrics_header(&buf, "pglogical_ticker_last_tick_age_seconds", "gauge",
+						  "Time since the last successful tick of the replication set.");
+	for (i = 0; i < nentries; i++)
+	{
+		char	   *dbname;
+
+		if (entries[i].last_tick_time == 0)
+			continue;
+		dbname = get_database_name(entries[i].key.dbid);
+		if (dbname == NULL)
+			continue;
+		ticker_metrics_worker(&buf, "pglogical_ticker_last_tick_age_seconds", dbname);
+		appendStringInfoString(&buf, ",set_name=\"");
+		ticker_metrics_label(&buf, NameStr(entries[i].key.set_name));
+		appendStringInfo(&buf, "\"} %.6f\n",
+						 Max(now - entries[i].last_tick_time, 0) / 1000000.0);
+	}
+
+	ticker_metrics_header(&buf, "pglogical_ticker_set_consecutive_errors", "gauge",
+						  "Ticks of the replication set that failed since the last successful one.");
+	for (i = 0; i < nentries; i++)
+	{
+		char	   *dbname;
+
+		dbname = get_database_name(entries[i].key.dbid);
+		if (dbname == NULL)
+			continue;
+		ticker_metrics_worker(&buf, "pglogical_ticker_set_consecutive_errors", dbname);
+		appendStringInfoString(&buf, ",set_name=\"");
+		ticker_metrics_label(&buf, NameStr(entries[i].key.set_name));
+		appendStringInfo(&buf, "\"} " INT64_FORMAT "\n", entries[i].consecutive_errors);
+	}
+
+	pfree(workers);
+	pfree(entries);
+
+	PG_RETURN_TEXT_P(cstring_to_text_with_len(buf.data, buf.len));
+}
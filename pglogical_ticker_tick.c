@@ -0,0 +1,1198 @@
+/* -------------------------------------------------------------------------
+ *
+ * pglogical_ticker_tick.c
+ *		Native tick path used by the background worker.
+ *
+ * This does the same work as the plpgsql function pglogical_ticker.tick(),
+ * but keeps the resolved list of ticker tables and one prepared plan per
+ * ticker table across cycles, so that a steady-state tick does not go
+ * through the parser and planner for every replication set.  The list is
+ * only re-read after a relcache invalidation of a relation in the
+ * pglogical_ticker or pglogical schema, which is what creating, dropping or
+ * renaming a ticker table, adding it to or removing it from a replication
+ * set, and changing pglogical_ticker.set_config cause.  In steady state, a
+ * tick does no catalog work at all.
+ *
+ * It also schedules the ticks.  Replication sets are grouped by their tick
+ * interval from pglogical_ticker.set_config, sets without an entry there
+ * following pglogical_ticker.naptime, and the groups are kept in a heap
+ * ordered by their next deadline, so the worker only wakes up when some
+ * group is due.
+ *
+ * With pglogical_ticker.auto_provision, it also deploys the ticker tables of
+ * new replication sets and adds them to replication, see
+ * pglogical_ticker_provision().
+ *
+ * All functions here expect to be called inside a transaction, with SPI
+ * connected and an active snapshot, as set up by the worker main loop.
+ *
+ * -------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "miscadmin.h"
+#include "access/xact.h"
+#include "catalog/namespace.h"
+#include "catalog/pg_type.h"
+#include "commands/trigger.h"
+#include "executor/spi.h"
+#include "lib/binaryheap.h"
+#include "lib/stringinfo.h"
+#include "utils/array.h"
+#include "utils/builtins.h"
+#include "utils/inval.h"
+#include "utils/lsyscache.h"
+#include "utils/memutils.h"
+#include "utils/pg_lsn.h"
+#include "utils/rel.h"
+#include "utils/syscache.h"
+#include "utils/timestamp.h"
+
+#include "pglogical_ticker.h"
+
+/*
+ * Replication sets which have a ticker table that is in replication.
+ * This is the same list pglogical_ticker.tick() loops over, minus the sets
+ * disabled in pglogical_ticker.set_config, with their tick interval in
+ * microseconds (0 for the default interval), and whether their ticker table
+ * has the prev_tick_lsn column added in version 1.5.
+ */
+#define TICKER_SET_LIST_QUERY(interval_expr, config_join, config_filter) \
+	"SELECT rs.set_name, c.oid, " interval_expr ", " \
+	"  EXISTS (SELECT 1 FROM pg_catalog.pg_attribute a " \
+	"    WHERE a.attrelid = c.oid AND a.attname = 'prev_tick_lsn' " \
+	"      AND NOT a.attisdropped) " \
+	"FROM pglogical.replication_set rs " \
+	"INNER JOIN pg_catalog.pg_class c ON c.relname = rs.set_name " \
+	"INNER JOIN pg_catalog.pg_namespace n ON n.oid = c.relnamespace " \
+	config_join \
+	"WHERE n.nspname = 'pglogical_ticker' " \
+	config_filter \
+	"  AND EXISTS " \
+	"    (SELECT 1 " \
+	"    FROM pglogical_ticker.rep_set_table_wrapper() rst " \
+	"    WHERE c.oid = rst.set_reloid) " \
+	"ORDER BY rs.set_name"
+
+#define TICKER_SET_LIST_CONFIG_QUERY \
+	TICKER_SET_LIST_QUERY( \
+		"COALESCE((extract(epoch FROM sc.tick_interval) * 1000000)::bigint, 0)", \
+		"LEFT JOIN pglogical_ticker.set_config sc ON sc.set_name = rs.set_name ", \
+		"  AND COALESCE(sc.enabled, true) ")
+
+/* Extension versions before 1.5 have no set_config table */
+#define TICKER_SET_LIST_NOCONFIG_QUERY \
+	TICKER_SET_LIST_QUERY("0::bigint", "", "")
+
+/*
+ * Tick statement for one ticker table.  The set name is passed as $1 so that
+ * the plan only depends on the target table, and the commit LSN of the
+ * previous tick as $2, which is written to ticker tables that have a
+ * prev_tick_lsn column.
+ */
+#define TICKER_TICK_QUERY(lsn_column, lsn_value, lsn_update) \
+	"INSERT INTO pglogical_ticker.%s (provider_name, source_time" lsn_column ") " \
+	"SELECT ni.if_name, now() AS source_time" lsn_value " " \
+	"FROM pglogical.replication_set rs " \
+	"INNER JOIN pglogical.node n ON n.node_id = rs.set_nodeid " \
+	"INNER JOIN pglogical.node_interface ni ON ni.if_nodeid = n.node_id " \
+	"WHERE rs.set_name = $1 " \
+	"ON CONFLICT (provider_name) " \
+	"DO UPDATE " \
+	"SET source_time = EXCLUDED.source_time" lsn_update
+
+#define TICKER_TICK_LSN_QUERY \
+	TICKER_TICK_QUERY(", prev_tick_lsn", ", $2", \
+					  ", prev_tick_lsn = EXCLUDED.prev_tick_lsn")
+
+#define TICKER_TICK_NOLSN_QUERY \
+	TICKER_TICK_QUERY("", "", "")
+
+/*
+ * Batched tick: one statement that writes every ticker table, with the
+ * provider interface names of all sets resolved once in a shared CTE.  Each
+ * ticker table gets its own data-modifying CTE built from TICKER_BATCH_PART.
+ * The commit LSN of the previous tick is passed as $1.
+ */
+#define TICKER_BATCH_HEAD \
+	"WITH provider AS ( " \
+	"SELECT rs.set_name, ni.if_name " \
+	"FROM pglogical.replication_set rs " \
+	"INNER JOIN pglogical.node n ON n.node_id = rs.set_nodeid " \
+	"INNER JOIN pglogical.node_interface ni ON ni.if_nodeid = n.node_id " \
+	")"
+
+#define TICKER_BATCH_PART(lsn_column, lsn_value, lsn_update) \
+	", t%d AS ( " \
+	"INSERT INTO pglogical_ticker.%s (provider_name, source_time" lsn_column ") " \
+	"SELECT if_name, now() AS source_time" lsn_value " " \
+	"FROM provider " \
+	"WHERE set_name = %s " \
+	"ON CONFLICT (provider_name) " \
+	"DO UPDATE " \
+	"SET source_time = EXCLUDED.source_time" lsn_update " " \
+	")"
+
+#define TICKER_BATCH_LSN_PART \
+	TICKER_BATCH_PART(", prev_tick_lsn", ", $1", \
+					  ", prev_tick_lsn = EXCLUDED.prev_tick_lsn")
+
+#define TICKER_BATCH_NOLSN_PART \
+	TICKER_BATCH_PART("", "", "")
+
+/*
+ * Sets of an array, in its order, which have no ticker table.
+ */
+#define TICKER_UNPROVISIONED_QUERY \
+	"SELECT s.set_name FROM unnest($1) WITH ORDINALITY s(set_name, n) " \
+	"WHERE NOT EXISTS (SELECT 1 FROM pg_catalog.pg_class c " \
+	"JOIN pg_catalog.pg_namespace n ON n.oid = c.relnamespace " \
+	"WHERE n.nspname = 'pglogical_ticker' AND c.relname = s.set_name) " \
+	"ORDER BY s.n"
+
+/* Longest wait before provisioning a failed set again */
+#define TICKER_PROVISION_MAX_BACKOFF_US	USECS_PER_HOUR
+
+/*
+ * Relations invalidated since the last tick, which are looked at when the
+ * next tick starts.  Beyond this many, the set list is simply re-read.
+ */
+#define TICKER_MAX_PENDING_RELIDS	64
+
+PG_FUNCTION_INFO_V1(pglogical_ticker_set_config_changed);
+
+typedef struct TickerSet
+{
+	NameData	set_name;
+	Oid			relid;
+	int64		interval;		/* microseconds, 0 for the default */
+	bool		has_prev_lsn;	/* ticker table has prev_tick_lsn */
+	SPIPlanPtr	plan;			/* kept plan, or NULL until first used */
+} TickerSet;
+
+/*
+ * Replication sets sharing a tick interval, which are ticked together.  The
+ * group of the default interval always exists, even without members, so that
+ * new ticker tables are picked up within the default interval.
+ */
+typedef struct TickerGroup
+{
+	int64		interval;		/* microseconds, 0 for the default */
+	int64		next_tick;		/* deadline, on the worker's clock */
+	bool		due;			/* to be ticked by the current tick */
+	int		   *members;		/* indexes into ticker_sets */
+	int			nmembers;
+	SPIPlanPtr	batch_plan;		/* batched tick plan, or NULL */
+} TickerGroup;
+
+/* Cached ticker tables, ordered by set_name, allocated in TopMemoryContext */
+static TickerSet *ticker_sets = NULL;
+static int	ticker_nsets = 0;
+
+/* Tick groups, and a heap of their indexes with the earliest deadline first */
+static TickerGroup *ticker_groups = NULL;
+static int	ticker_ngroups = 0;
+static binaryheap *ticker_heap = NULL;
+
+/* Clock and default interval as of the last pglogical_ticker_schedule() */
+static int64 ticker_now = 0;
+static int64 ticker_default_interval = 0;
+
+/* Shared memory status entries, parallel to ticker_sets */
+static TickerSetStatus **ticker_status = NULL;
+
+/* Index of the set being ticked on its own, or -1 */
+static int	ticker_current_set = -1;
+
+/* Commit LSN of the previous tick of this worker, written to prev_tick_lsn */
+static XLogRecPtr ticker_prev_commit_lsn = InvalidXLogRecPtr;
+
+/* tick_now() requests taken by the current tick */
+static int64 ticker_taken_requests = 0;
+
+/*
+ * Replication sets seen by the last provisioning check, and those of them
+ * whose ticker table could not be provisioned, sorted, allocated in
+ * TopMemoryContext.  When the next check and the next retry of the failed
+ * sets are due on the worker's clock, and how long the last retry waited.
+ */
+static NameData *ticker_known_sets = NULL;
+static int	ticker_nknown_sets = 0;
+static NameData *ticker_failed_sets = NULL;
+static int	ticker_nfailed_sets = 0;
+static int64 ticker_next_provision = 0;
+static int64 ticker_next_provision_retry = 0;
+static int64 ticker_provision_backoff = 0;
+static SPIPlanPtr ticker_provision_plan = NULL;
+static SPIPlanPtr ticker_unprovisioned_plan = NULL;
+
+static SPIPlanPtr ticker_set_list_plan = NULL;
+static bool ticker_set_list_has_config = false;
+
+/* Invalidation state of the set list, see ticker_relcache_callback() */
+static bool ticker_callbacks_registered = false;
+static bool ticker_sets_valid = false;
+static Oid	ticker_pending_relids[TICKER_MAX_PENDING_RELIDS];
+static int	ticker_npending_relids = 0;
+
+/* Namespaces the set list depends on, or InvalidOid if not looked up yet */
+static Oid	ticker_nspid = InvalidOid;
+static Oid	ticker_pglogical_nspid = InvalidOid;
+
+/*
+ * Prepare a plan which is kept across transactions, with SPI connected.
+ */
+SPIPlanPtr
+ticker_prepare_kept(const char *query, int nargs, Oid *argtypes)
+{
+	SPIPlanPtr	plan;
+
+	plan = SPI_prepare(query, nargs, argtypes);
+	if (plan == NULL)
+		elog(ERROR, "pglogical_ticker: SPI_prepare failed: %s",
+			 SPI_result_code_string(SPI_result));
+	if (SPI_keepplan(plan))
+		elog(ERROR, "pglogical_ticker: SPI_keepplan failed");
+
+	return plan;
+}
+
+static int64
+ticker_group_interval(TickerGroup *group)
+{
+	return group->interval > 0 ? group->interval : ticker_default_interval;
+}
+
+/*
+ * binaryheap keeps the largest element first, so order groups by reverse
+ * deadline to get the earliest deadline first.
+ */
+static int
+ticker_group_cmp(Datum a, Datum b, void *arg)
+{
+	int64		ta = ticker_groups[DatumGetInt32(a)].next_tick;
+	int64		tb = ticker_groups[DatumGetInt32(b)].next_tick;
+
+	if (ta < tb)
+		return 1;
+	if (ta > tb)
+		return -1;
+	return 0;
+}
+
+static void
+ticker_build_heap(void)
+{
+	int			i;
+
+	binaryheap_reset(ticker_heap);
+	for (i = 0; i < ticker_ngroups; i++)
+		binaryheap_add_unordered(ticker_heap, Int32GetDatum(i));
+	binaryheap_build(ticker_heap);
+}
+
+/*
+ * Regroup ticker_sets by interval.  A group whose interval existed before
+ * keeps its deadline, so changing the set list does not disturb the cadence
+ * of the other sets; a new group is due right away.
+ */
+static void
+ticker_build_groups(void)
+{
+	TickerGroup *new_groups;
+	int			new_ngroups = 0;
+	MemoryContext oldcontext;
+	int			i;
+	int			g;
+
+	oldcontext = MemoryContextSwitchTo(TopMemoryContext);
+
+	new_groups = (TickerGroup *) palloc0((ticker_nsets + 1) * sizeof(TickerGroup));
+	new_ngroups = 1;
+	for (i = 0; i < ticker_nsets; i++)
+	{
+		for (g = 0; g < new_ngroups; g++)
+		{
+			if (new_groups[g].interval == ticker_sets[i].interval)
+				break;
+		}
+		if (g == new_ngroups)
+		{
+			new_groups[g].interval = ticker_sets[i].interval;
+			new_ngroups++;
+		}
+		if (new_groups[g].members == NULL)
+			new_groups[g].members = (int *) palloc(ticker_nsets * sizeof(int));
+		new_groups[g].members[new_groups[g].nmembers++] = i;
+	}
+
+	for (g = 0; g < new_ngroups; g++)
+	{
+		TickerGroup *group = &new_groups[g];
+
+		for (i = 0; i < ticker_ngroups; i++)
+		{
+			if (ticker_groups[i].interval == group->interval)
+				break;
+		}
+		if (i < ticker_ngroups)
+		{
+			group->next_tick = ticker_groups[i].next_tick;
+			group->due = ticker_groups[i].due;
+		}
+		else
+		{
+			group->next_tick = ticker_now + ticker_group_interval(group);
+			group->due = true;
+		}
+	}
+
+	for (i = 0; i < ticker_ngroups; i++)
+	{
+		if (ticker_groups[i].members != NULL)
+			pfree(ticker_groups[i].members);
+		if (ticker_groups[i].batch_plan != NULL)
+			SPI_freeplan(ticker_groups[i].batch_plan);
+	}
+	if (ticker_groups != NULL)
+		pfree(ticker_groups);
+	if (ticker_heap != NULL)
+		binaryheap_free(ticker_heap);
+
+	ticker_groups = new_groups;
+	ticker_ngroups = new_ngroups;
+	ticker_heap = binaryheap_allocate(ticker_ngroups, ticker_group_cmp, NULL);
+	ticker_build_heap();
+
+	MemoryContextSwitchTo(oldcontext);
+}
+
+/*
+ * Relcache invalidation callback.  No catalog access is allowed here, so the
+ * relation is only remembered, and ticker_sets_changed() checks it when the
+ * next tick starts.  An invalidation of all relations, as after a sinval
+ * queue overflow, means the set list has to be re-read.
+ */
+static void
+ticker_relcache_callback(Datum arg, Oid relid)
+{
+	if (!OidIsValid(relid) ||
+		ticker_npending_relids >= TICKER_MAX_PENDING_RELIDS)
+	{
+		ticker_sets_valid = false;
+		return;
+	}
+
+	ticker_pending_relids[ticker_npending_relids++] = relid;
+}
+
+/*
+ * Syscache invalidation callback for namespaces: the schemas may have been
+ * dropped, renamed or created, so forget their OIDs and the set list.
+ */
+static void
+ticker_namespace_callback(Datum arg, int cacheid, uint32 hashvalue)
+{
+	ticker_nspid = InvalidOid;
+	ticker_pglogical_nspid = InvalidOid;
+	ticker_sets_valid = false;
+}
+
+/*
+ * Does any invalidation since the last refresh concern the set list?
+ */
+static bool
+ticker_sets_changed(void)
+{
+	Oid			relids[TICKER_MAX_PENDING_RELIDS];
+	int			nrelids;
+	int			i;
+	int			j;
+
+	if (!ticker_callbacks_registered)
+	{
+		CacheRegisterRelcacheCallback(ticker_relcache_callback, (Datum) 0);
+		CacheRegisterSyscacheCallback(NAMESPACEOID, ticker_namespace_callback,
+									  (Datum) 0);
+		ticker_callbacks_registered = true;
+	}
+
+	if (!ticker_sets_valid)
+		return true;
+	if (ticker_npending_relids == 0)
+		return false;
+
+	/* Catalog lookups below may process more invalidations */
+	nrelids = ticker_npending_relids;
+	memcpy(relids, ticker_pending_relids, nrelids * sizeof(Oid));
+	ticker_npending_relids = 0;
+
+	if (!OidIsValid(ticker_nspid))
+		ticker_nspid = get_namespace_oid("pglogical_ticker", true);
+	if (!OidIsValid(ticker_pglogical_nspid))
+		ticker_pglogical_nspid = get_namespace_oid("pglogical", true);
+
+	for (i = 0; i < nrelids; i++)
+	{
+		Oid			nspid;
+
+		/* A dropped ticker table has no namespace any more */
+		for (j = 0; j < ticker_nsets; j++)
+		{
+			if (ticker_sets[j].relid == relids[i])
+				return true;
+		}
+
+		nspid = get_rel_namespace(relids[i]);
+		if (OidIsValid(nspid) &&
+			(nspid == ticker_nspid || nspid == ticker_pglogical_nspid))
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * Does the extension have the set_config table, i.e. is it at version 1.5
+ * or later?
+ */
+static bool
+ticker_has_set_config(void)
+{
+	Oid			nspid = get_namespace_oid("pglogical_ticker", true);
+
+	return OidIsValid(nspid) &&
+		OidIsValid(get_relname_relid("set_config", nspid));
+}
+
+/*
+ * Re-read the list of ticker tables and merge it into the cache.
+ *
+ * Both lists are ordered by set name, so entries whose set and table did not
+ * change keep their prepared plan.  Plans of sets which went away are freed.
+ * Nothing is done unless ticker_sets_changed() says so.
+ */
+static void
+ticker_refresh_sets(void)
+{
+	TickerSet  *new_sets;
+	int			new_nsets;
+	int			ret;
+	int			i;
+	int			j;
+	bool		changed;
+	bool		has_config;
+
+	if (!ticker_sets_changed())
+		return;
+
+	/* Invalidations from here on are for the next refresh */
+	ticker_sets_valid = true;
+	ticker_npending_relids = 0;
+
+	has_config = ticker_has_set_config();
+	if (ticker_set_list_plan != NULL && has_config != ticker_set_list_has_config)
+	{
+		SPI_freeplan(ticker_set_list_plan);
+		ticker_set_list_plan = NULL;
+	}
+	if (ticker_set_list_plan == NULL)
+	{
+		ticker_set_list_plan =
+			ticker_prepare_kept(has_config ? TICKER_SET_LIST_CONFIG_QUERY :
+								TICKER_SET_LIST_NOCONFIG_QUERY, 0, NULL);
+		ticker_set_list_has_config = has_config;
+	}
+
+	ret = SPI_execute_plan(ticker_set_list_plan, NULL, NULL, true, 0);
+	if (ret != SPI_OK_SELECT)
+		elog(ERROR, "pglogical_ticker: could not read replication sets: %s",
+			 SPI_result_code_string(ret));
+
+	new_nsets = (int) SPI_processed;
+	changed = (ticker_sets == NULL || new_nsets != ticker_nsets);
+
+	for (i = 0; i < new_nsets && !changed; i++)
+	{
+		HeapTuple	tuple = SPI_tuptable->vals[i];
+		TupleDesc	tupdesc = SPI_tuptable->tupdesc;
+		bool		isnull;
+		Name		set_name;
+		Oid			relid;
+		int64		interval;
+		bool		has_prev_lsn;
+
+		set_name = DatumGetName(SPI_getbinval(tuple, tupdesc, 1, &isnull));
+		relid = DatumGetObjectId(SPI_getbinval(tuple, tupdesc, 2, &isnull));
+		interval = DatumGetInt64(SPI_getbinval(tuple, tupdesc, 3, &isnull));
+		has_prev_lsn = DatumGetBool(SPI_getbinval(tuple, tupdesc, 4, &isnull));
+
+		if (relid != ticker_sets[i].relid ||
+			interval != ticker_sets[i].interval ||
+			has_prev_lsn != ticker_sets[i].has_prev_lsn ||
+			strcmp(NameStr(*set_name), NameStr(ticker_sets[i].set_name)) != 0)
+			changed = true;
+	}
+
+	if (!changed)
+		return;
+
+	new_sets = (TickerSet *)
+		MemoryContextAllocZero(TopMemoryContext,
+							   Max(new_nsets, 1) * sizeof(TickerSet));
+
+	for (i = 0; i < new_nsets; i++)
+	{
+		HeapTuple	tuple = SPI_tuptable->vals[i];
+		TupleDesc	tupdesc = SPI_tuptable->tupdesc;
+		bool		isnull;
+
+		namestrcpy(&new_sets[i].set_name,
+				   NameStr(*DatumGetName(SPI_getbinval(tuple, tupdesc, 1, &isnull))));
+		new_sets[i].relid =
+			DatumGetObjectId(SPI_getbinval(tuple, tupdesc, 2, &isnull));
+		new_sets[i].interval =
+			DatumGetInt64(SPI_getbinval(tuple, tupdesc, 3, &isnull));
+		new_sets[i].has_prev_lsn =
+			DatumGetBool(SPI_getbinval(tuple, tupdesc, 4, &isnull));
+	}
+
+	/* Carry over plans of unchanged entries */
+	i = 0;
+	j = 0;
+	while (i < ticker_nsets && j < new_nsets)
+	{
+		int			cmp = strcmp(NameStr(ticker_sets[i].set_name),
+								 NameStr(new_sets[j].set_name));
+
+		if (cmp == 0 && ticker_sets[i].relid == new_sets[j].relid &&
+			ticker_sets[i].has_prev_lsn == new_sets[j].has_prev_lsn)
+		{
+			new_sets[j].plan = ticker_sets[i].plan;
+			ticker_sets[i].plan = NULL;
+			i++;
+			j++;
+		}
+		else if (cmp <= 0)
+			i++;
+		else
+			j++;
+	}
+
+	for (i = 0; i < ticker_nsets; i++)
+	{
+		if (ticker_sets[i].plan != NULL)
+			SPI_freeplan(ticker_sets[i].plan);
+	}
+	if (ticker_sets != NULL)
+		pfree(ticker_sets);
+
+	ticker_sets = new_sets;
+	ticker_nsets = new_nsets;
+	ticker_build_groups();
+
+	/* Keep the shared memory registry in line with the set list */
+	if (ticker_status != NULL)
+		pfree(ticker_status);
+	ticker_status = (TickerSetStatus **)
+		MemoryContextAllocZero(TopMemoryContext,
+							   Max(ticker_nsets, 1) * sizeof(TickerSetStatus *));
+	if (pglogical_ticker_shmem_enabled())
+	{
+		for (i = 0; i < ticker_nsets; i++)
+			ticker_status[i] = ticker_status_enter(MyDatabaseId,
+												   NameStr(ticker_sets[i].set_name));
+		ticker_status_prune(MyDatabaseId, ticker_status, ticker_nsets);
+	}
+
+	elog(DEBUG1, "pglogical_ticker: ticking %d replication sets in %d groups",
+		 ticker_nsets, ticker_ngroups);
+}
+
+static SPIPlanPtr
+ticker_set_plan(TickerSet *set)
+{
+	StringInfoData buf;
+	Oid			argtypes[2] = {NAMEOID, LSNOID};
+
+	if (set->plan != NULL)
+		return set->plan;
+
+	initStringInfo(&buf);
+	appendStringInfo(&buf,
+					 set->has_prev_lsn ? TICKER_TICK_LSN_QUERY : TICKER_TICK_NOLSN_QUERY,
+					 quote_identifier(NameStr(set->set_name)));
+
+	set->plan = ticker_prepare_kept(buf.data, 2, argtypes);
+	pfree(buf.data);
+
+	return set->plan;
+}
+
+static SPIPlanPtr
+ticker_group_batch_plan(TickerGroup *group)
+{
+	StringInfoData buf;
+	Oid			argtypes[1] = {LSNOID};
+	int			i;
+
+	if (group->batch_plan != NULL)
+		return group->batch_plan;
+
+	initStringInfo(&buf);
+	appendStringInfoString(&buf, TICKER_BATCH_HEAD);
+	for (i = 0; i < group->nmembers; i++)
+	{
+		TickerSet  *set = &ticker_sets[group->members[i]];
+
+		appendStringInfo(&buf,
+						 set->has_prev_lsn ? TICKER_BATCH_LSN_PART : TICKER_BATCH_NOLSN_PART,
+						 i,
+						 quote_identifier(NameStr(set->set_name)),
+						 quote_literal_cstr(NameStr(set->set_name)));
+	}
+	appendStringInfoString(&buf, " SELECT 1");
+
+	group->batch_plan = ticker_prepare_kept(buf.data, 1, argtypes);
+	pfree(buf.data);
+
+	return group->batch_plan;
+}
+
+/*
+ * Deadline of the next tick on the worker's clock.  Before the first tick,
+ * this is 0, so the first tick happens right away.
+ */
+int64
+pglogical_ticker_next_deadline(void)
+{
+	if (ticker_heap == NULL || binaryheap_empty(ticker_heap))
+		return 0;
+
+	return ticker_groups[DatumGetInt32(binaryheap_first(ticker_heap))].next_tick;
+}
+
+/*
+ * Mark the groups whose deadline has passed as due for the next tick, given
+ * the current time and default interval in microseconds.
+ *
+ * Ticks are scheduled on a fixed cadence: the next deadline of a group is its
+ * previous deadline plus its interval, so the time spent ticking and
+ * committing is not added to the period.  Deadlines a group is more than a
+ * whole interval behind on are skipped rather than ticked in a burst, and
+ * counted as missed.  A tick that starts more than a tenth of the interval
+ * after the deadline of one of its groups is counted as late.  Each call
+ * counts at most one tick, since the due groups are ticked together.
+ *
+ * A group without sets, which the default interval always has, keeps its
+ * deadline so that the worker wakes up to look for new ticker tables, but is
+ * neither marked due nor counted.
+ */
+void
+pglogical_ticker_schedule(int64 now, int64 interval)
+{
+	bool		due = false;
+	bool		late = false;
+	int64		missed = 0;
+
+	ticker_now = now;
+	ticker_default_interval = interval;
+
+	while (ticker_heap != NULL && !binaryheap_empty(ticker_heap))
+	{
+		Datum		first = binaryheap_first(ticker_heap);
+		TickerGroup *group = &ticker_groups[DatumGetInt32(first)];
+		int64		group_interval = ticker_group_interval(group);
+		int64		group_missed;
+
+		if (group->next_tick > now)
+			break;
+
+		group_missed = (now - group->next_tick) / group_interval;
+		if (group->nmembers > 0)
+		{
+			if (now - group->next_tick > group_interval / 10)
+				late = true;
+			missed += group_missed;
+			group->due = true;
+			due = true;
+		}
+		group->next_tick += (group_missed + 1) * group_interval;
+
+		binaryheap_replace_first(ticker_heap, first);
+	}
+
+	if (due)
+		ticker_worker_count_tick(interval, late, missed);
+}
+
+/*
+ * The default interval changed: a shorter one takes effect for the deadlines
+ * already waited for.
+ */
+void
+pglogical_ticker_reschedule(int64 now, int64 interval)
+{
+	int			i;
+
+	ticker_default_interval = interval;
+
+	if (ticker_heap == NULL)
+		return;
+
+	for (i = 0; i < ticker_ngroups; i++)
+	{
+		if (ticker_groups[i].interval == 0)
+			ticker_groups[i].next_tick = Min(ticker_groups[i].next_tick,
+											 now + interval);
+	}
+	ticker_build_heap();
+}
+
+/*
+ * Does pglogical_ticker_provision() have anything to do, given the current
+ * time on the worker's clock?  Turning pglogical_ticker.auto_provision off
+ * forgets the sets seen so far, so that turning it on again looks at all of
+ * them.
+ */
+bool
+pglogical_ticker_provision_due(int64 now)
+{
+	if (!pglogical_ticker_auto_provision)
+	{
+		ticker_nknown_sets = 0;
+		ticker_nfailed_sets = 0;
+		ticker_provision_backoff = 0;
+		return false;
+	}
+
+	return now >= ticker_next_provision;
+}
+
+/*
+ * Is set_name in names, which is sorted, looking from *pos on?  Advances *pos
+ * past the names that sort before set_name, so that walking a sorted list of
+ * set names checks all of them in a single pass over names.
+ */
+static bool
+ticker_sorted_names_contain(NameData *names, int nnames, int *pos,
+							const char *set_name)
+{
+	while (*pos < nnames && strcmp(NameStr(names[*pos]), set_name) < 0)
+		(*pos)++;
+
+	return *pos < nnames && strcmp(NameStr(names[*pos]), set_name) == 0;
+}
+
+/*
+ * Replace a sorted list of set names kept in TopMemoryContext.
+ */
+static void
+ticker_keep_names(NameData **names, int *nnames, NameData *new_names,
+				  int new_nnames)
+{
+	if (*names != NULL)
+		pfree(*names);
+	*names = (NameData *)
+		MemoryContextAlloc(TopMemoryContext, Max(new_nnames, 1) * sizeof(NameData));
+	if (new_nnames > 0)
+		memcpy(*names, new_names, new_nnames * sizeof(NameData));
+	*nnames = new_nnames;
+}
+
+/*
+ * With pglogical_ticker.auto_provision, deploy and add to replication the
+ * ticker tables of the replication sets created since the last check, once
+ * per default interval.  The worker runs this in a transaction of its own
+ * before ticking, so that ticks do not wait on the locks taken by the DDL.
+ *
+ * Only the names of the sets are read, and compared to the ones the last
+ * check saw, so the sets which were there already cost nothing more; the
+ * first check after the worker starts looks at all of them.  The new sets
+ * are passed to pglogical_ticker.provision_ticker_tables(), which skips the
+ * ones that have a ticker table.  Creating the tables invalidates the set
+ * list, so they are ticked from the next tick on.
+ *
+ * A set whose ticker table could not be provisioned is tried again, after
+ * the default interval at first, then twice as long after each failure, up
+ * to TICKER_PROVISION_MAX_BACKOFF_US.
+ */
+void
+pglogical_ticker_provision(int64 now)
+{
+	NameData   *sets;
+	int			nsets;
+	Datum	   *passed;
+	int			npassed = 0;
+	NameData   *failed;
+	int			nfailed = 0;
+	int			npassed_failed = 0;
+	bool	   *was_passed;
+	bool	   *is_failed;
+	bool		retry;
+	int			known_pos = 0;
+	int			failed_pos = 0;
+	int			i;
+
+	ticker_next_provision = now + ticker_default_interval;
+
+	/* set_config comes with version 1.5, as provision_ticker_tables() does */
+	if (!ticker_has_set_config())
+		return;
+
+	retry = ticker_nfailed_sets > 0 && now >= ticker_next_provision_retry;
+
+	sets = ticker_repset_names(&nsets);
+	passed = (Datum *) palloc(Max(nsets, 1) * sizeof(Datum));
+	was_passed = (bool *) palloc0(Max(nsets, 1) * sizeof(bool));
+	is_failed = (bool *) palloc0(Max(nsets, 1) * sizeof(bool));
+	for (i = 0; i < nsets; i++)
+	{
+		bool		known;
+		bool		was_failed;
+
+		known = ticker_sorted_names_contain(ticker_known_sets, ticker_nknown_sets,
+											&known_pos, NameStr(sets[i]));
+		was_failed = ticker_sorted_names_contain(ticker_failed_sets, ticker_nfailed_sets,
+												 &failed_pos, NameStr(sets[i]));
+
+		if (!known || (was_failed && retry))
+		{
+			passed[npassed++] = NameGetDatum(&sets[i]);
+			was_passed[i] = true;
+		}
+		else if (was_failed)
+			is_failed[i] = true;
+	}
+
+	if (npassed > 0)
+	{
+		Datum		arg;
+		char		argnull = ' ';
+		int			ret;
+		uint64		row;
+		int			pos = 0;
+
+		if (ticker_provision_plan == NULL)
+		{
+			Oid			argtype = get_array_type(NAMEOID);
+
+			ticker_provision_plan =
+				ticker_prepare_kept("SELECT pglogical_ticker.provision_ticker_tables($1)",
+									1, &argtype);
+		}
+		if (ticker_unprovisioned_plan == NULL)
+		{
+			Oid			argtype = get_array_type(NAMEOID);
+
+			ticker_unprovisioned_plan =
+				ticker_prepare_kept(TICKER_UNPROVISIONED_QUERY, 1, &argtype);
+		}
+
+		arg = PointerGetDatum(construct_array(passed, npassed, NAMEOID,
+											  NAMEDATALEN, false, 'c'));
+		ret = SPI_execute_plan(ticker_provision_plan, &arg, &argnull, false, 1);
+		if (ret != SPI_OK_SELECT)
+			elog(ERROR, "pglogical_ticker: could not provision ticker tables: %s",
+				 SPI_result_code_string(ret));
+
+		if (SPI_processed == 1)
+		{
+			bool		isnull;
+			Datum		provisioned;
+
+			provisioned = SPI_getbinval(SPI_tuptable->vals[0],
+										SPI_tuptable->tupdesc, 1, &isnull);
+			if (!isnull && DatumGetInt32(provisioned) > 0)
+			{
+				elog(LOG, "pglogical_ticker: provisioned the ticker tables of %d new replication sets",
+					 DatumGetInt32(provisioned));
+				ticker_sets_valid = false;
+			}
+		}
+
+		/* The sets passed which still have no ticker table have failed */
+		ret = SPI_execute_plan(ticker_unprovisioned_plan, &arg, &argnull, true, 0);
+		if (ret != SPI_OK_SELECT)
+			elog(ERROR, "pglogical_ticker: could not list unprovisioned sets: %s",
+				 SPI_result_code_string(ret));
+
+		for (row = 0; row < SPI_processed; row++)
+		{
+			bool		isnull;
+			Datum		set_name;
+
+			set_name = SPI_getbinval(SPI_tuptable->vals[row],
+									 SPI_tuptable->tupdesc, 1, &isnull);
+			if (isnull)
+				continue;
+			/* the rows come in the order of the sets passed, which is sorted */
+			while (pos < nsets &&
+				   strcmp(NameStr(sets[pos]), NameStr(*DatumGetName(set_name))) < 0)
+				pos++;
+			if (pos < nsets && was_passed[pos])
+			{
+				is_failed[pos] = true;
+				npassed_failed++;
+			}
+		}
+	}
+
+	failed = (NameData *) palloc(Max(nsets, 1) * sizeof(NameData));
+	for (i = 0; i < nsets; i++)
+	{
+		if (is_failed[i])
+			failed[nfailed++] = sets[i];
+	}
+
+	if (nfailed == 0)
+		ticker_provision_backoff = 0;
+	else if (npassed_failed > 0)
+	{
+		ticker_provision_backoff = ticker_provision_backoff == 0 ?
+			ticker_default_interval :
+			Min(ticker_provision_backoff * 2, TICKER_PROVISION_MAX_BACKOFF_US);
+		ticker_next_provision_retry = now + ticker_provision_backoff;
+	}
+
+	ticker_keep_names(&ticker_known_sets, &ticker_nknown_sets, sets, nsets);
+	ticker_keep_names(&ticker_failed_sets, &ticker_nfailed_sets, failed, nfailed);
+
+	pfree(failed);
+	pfree(is_failed);
+	pfree(was_passed);
+	pfree(passed);
+	if (sets != NULL)
+		pfree(sets);
+}
+
+/*
+ * Is any replication set due for a tick?
+ */
+bool
+pglogical_ticker_tick_due(void)
+{
+	int			g;
+
+	for (g = 0; g < ticker_ngroups; g++)
+	{
+		if (ticker_groups[g].due && ticker_groups[g].nmembers > 0)
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * Pick up the replication sets created, and the ticker tables created or
+ * dropped, since the last tick, when no set is due.  Sets picked up for the
+ * first time are due right away.
+ */
+void
+pglogical_ticker_refresh(void)
+{
+	ticker_report_wait_start(TICKER_WAIT_CATALOG_REFRESH);
+	ticker_refresh_sets();
+	ticker_report_wait_end();
+}
+
+/*
+ * Take the pending tick_now() requests, and mark the groups of the requested
+ * sets as due.  The deadlines of those groups are left as they are.
+ */
+static void
+ticker_take_tick_requests(void)
+{
+	bool	   *requested;
+	int			g;
+	int			i;
+
+	requested = (bool *) palloc0(Max(ticker_nsets, 1) * sizeof(bool));
+	ticker_taken_requests = ticker_worker_take_tick_requests(ticker_status,
+															 ticker_nsets,
+															 requested);
+
+	for (g = 0; g < ticker_ngroups; g++)
+	{
+		for (i = 0; i < ticker_groups[g].nmembers; i++)
+		{
+			if (requested[ticker_groups[g].members[i]])
+				ticker_groups[g].due = true;
+		}
+	}
+
+	pfree(requested);
+}
+
+/*
+ * Tick the replication sets of the groups which are due, or which
+ * tick_now() asked for.
+ *
+ * With pglogical_ticker.batch_tick, all ticker tables of a group are written
+ * by a single statement; otherwise each table is ticked by its own plan.
+ */
+void
+pglogical_ticker_tick(void)
+{
+	int			g;
+	int			i;
+	Datum		prev_lsn = LSNGetDatum(ticker_prev_commit_lsn);
+	char		prev_lsn_null = XLogRecPtrIsInvalid(ticker_prev_commit_lsn) ? 'n' : ' ';
+
+	ticker_current_set = -1;
+	ticker_report_wait_start(TICKER_WAIT_CATALOG_REFRESH);
+	ticker_refresh_sets();
+	ticker_take_tick_requests();
+	ticker_report_wait_start(TICKER_WAIT_TICK);
+
+	for (g = 0; g < ticker_ngroups; g++)
+	{
+		TickerGroup *group = &ticker_groups[g];
+
+		if (!group->due || group->nmembers == 0)
+			continue;
+
+		if (pglogical_ticker_batch_tick)
+		{
+			int			ret;
+
+			ret = SPI_execute_plan(ticker_group_batch_plan(group),
+								   &prev_lsn, &prev_lsn_null, false, 0);
+			if (ret != SPI_OK_SELECT)
+				elog(ERROR, "pglogical_ticker: could not tick: %s",
+					 SPI_result_code_string(ret));
+			continue;
+		}
+
+		for (i = 0; i < group->nmembers; i++)
+		{
+			TickerSet  *set = &ticker_sets[group->members[i]];
+			Datum		values[2];
+			char		nulls[2] = {' ', prev_lsn_null};
+			int			ret;
+
+			values[0] = NameGetDatum(&set->set_name);
+			values[1] = prev_lsn;
+
+			ticker_current_set = group->members[i];
+			ret = SPI_execute_plan(ticker_set_plan(set), values, nulls, false, 0);
+			if (ret != SPI_OK_INSERT)
+				elog(ERROR, "pglogical_ticker: could not tick \"%s\": %s",
+					 NameStr(set->set_name), SPI_result_code_string(ret));
+		}
+	}
+	ticker_current_set = -1;
+	ticker_report_wait_end();
+}
+
+/*
+ * Collect the status entries of the sets of the due groups, and if intervals
+ * is not NULL the interval of the group of each.
+ */
+static int
+ticker_due_status(TickerSetStatus **entries, int64 *intervals)
+{
+	int			nentries = 0;
+	int			g;
+	int			i;
+
+	for (g = 0; g < ticker_ngroups; g++)
+	{
+		if (!ticker_groups[g].due)
+			continue;
+		for (i = 0; i < ticker_groups[g].nmembers; i++)
+		{
+			if (intervals != NULL)
+				intervals[nentries] = ticker_group_interval(&ticker_groups[g]);
+			entries[nentries++] = ticker_status[ticker_groups[g].members[i]];
+		}
+	}
+
+	return nentries;
+}
+
+/*
+ * Record a committed tick in the shared memory registry, and clear the due
+ * flags.
+ */
+void
+pglogical_ticker_tick_done(TimestampTz tick_time, TimestampTz commit_time,
+						   int64 duration, XLogRecPtr commit_lsn)
+{
+	int			g;
+
+	ticker_worker_count_tick_done(tick_time, duration, commit_lsn);
+	ticker_worker_serve_tick_requests(ticker_taken_requests, tick_time,
+									  commit_time, commit_lsn);
+	if (!XLogRecPtrIsInvalid(commit_lsn))
+		ticker_prev_commit_lsn = commit_lsn;
+
+	if (ticker_nsets > 0)
+	{
+		TickerSetStatus **entries;
+		int64	   *intervals;
+		int			nentries;
+
+		entries = (TickerSetStatus **)
+			MemoryContextAlloc(TopMemoryContext,
+							   ticker_nsets * sizeof(TickerSetStatus *));
+		intervals = (int64 *)
+			MemoryContextAlloc(TopMemoryContext, ticker_nsets * sizeof(int64));
+		nentries = ticker_due_status(entries, intervals);
+		ticker_status_report(entries, intervals, nentries,
+							 tick_time, duration, commit_lsn);
+		pfree(intervals);
+		pfree(entries);
+	}
+
+	for (g = 0; g < ticker_ngroups; g++)
+		ticker_groups[g].due = false;
+}
+
+/*
+ * Record a failed tick in the shared memory registry.  The error is charged
+ * to the set being ticked when it failed, or to every due set if it failed
+ * outside of a single set's statement.
+ */
+void
+pglogical_ticker_tick_failed(void)
+{
+	TickerSetStatus **entries;
+	int			nentries;
+
+	ticker_worker_count_tick_error();
+
+	if (ticker_nsets == 0)
+		return;
+
+	if (ticker_current_set >= 0 && ticker_current_set < ticker_nsets)
+	{
+		ticker_status_report_error(&ticker_status[ticker_current_set], 1);
+		return;
+	}
+
+	entries = (TickerSetStatus **)
+		MemoryContextAlloc(TopMemoryContext,
+						   ticker_nsets * sizeof(TickerSetStatus *));
+	nentries = ticker_due_status(entries, NULL);
+	ticker_status_report_error(entries, nentries);
+	pfree(entries);
+}
+
+/*
+ * Statement trigger on pglogical_ticker.set_config.  Changing the rows of a
+ * table does not invalidate its relcache entry, so do that here to make the
+ * workers re-read their set list.
+ */
+Datum
+pglogical_ticker_set_config_changed(PG_FUNCTION_ARGS)
+{
+	TriggerData *trigdata = (TriggerData *) fcinfo->context;
+
+	if (!CALLED_AS_TRIGGER(fcinfo))
+		elog(ERROR, "pglogical_ticker_set_config_changed: not called by trigger manager");
+
+	CacheInvalidateRelcache(trigdata->tg_relation);
+
+	PG_RETURN_POINTER(NULL);
+}
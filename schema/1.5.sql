@@ -0,0 +1,100 @@
+--Per replication set tick settings of the background worker.  Sets without
+--an entry here are ticked every pglogical_ticker.naptime.
+CREATE TABLE pglogical_ticker.set_config (
+    set_name NAME PRIMARY KEY,
+    tick_interval INTERVAL CHECK (tick_interval >= INTERVAL '1 millisecond'),
+    enabled BOOLEAN NOT NULL DEFAULT TRUE
+);
+SELECT pg_catalog.pg_extension_config_dump('pglogical_ticker.set_config', '');
+
+--Let the workers know they have to re-read the configuration
+CREATE TRIGGER set_config_changed
+AFTER INSERT OR UPDATE OR DELETE OR TRUNCATE ON pglogical_ticker.set_config
+FOR EACH STATEMENT EXECUTE PROCEDURE pglogical_ticker.set_config_changed();
+
+--Lag history, sampled by the worker on subscribers with
+--pglogical_ticker.lag_history on.  This needs declarative partitioning.
+DO $block$
+BEGIN
+IF current_setting('server_version_num')::INT >= 100000 THEN
+
+EXECUTE $$
+CREATE TABLE pglogical_ticker.lag_history (
+    sample_time TIMESTAMPTZ NOT NULL,
+    provider_name NAME NOT NULL,
+    set_name NAME NOT NULL,
+    lag INTERVAL NOT NULL
+) PARTITION BY RANGE (sample_time)
+$$;
+
+EXECUTE $$
+CREATE TABLE pglogical_ticker.lag_history_1m (
+    bucket TIMESTAMPTZ NOT NULL,
+    provider_name NAME NOT NULL,
+    set_name NAME NOT NULL,
+    samples BIGINT NOT NULL,
+    avg_lag INTERVAL NOT NULL,
+    max_lag INTERVAL NOT NULL
+) PARTITION BY RANGE (bucket)
+$$;
+
+EXECUTE $$
+CREATE TABLE pglogical_ticker.lag_history_1h (
+    bucket TIMESTAMPTZ NOT NULL,
+    provider_name NAME NOT NULL,
+    set_name NAME NOT NULL,
+    samples BIGINT NOT NULL,
+    avg_lag INTERVAL NOT NULL,
+    max_lag INTERVAL NOT NULL
+) PARTITION BY RANGE (bucket)
+$$;
+
+END IF;
+END
+$block$;
+
+--Optional consolidated layout of the ticker tables, as partitions of a
+--single table, see deploy_ticker_tables() and migrate_to_ticks().
+--Each partition keeps the name of its replication set and its own primary
+--key on provider_name, so ticking and replicating it works as with any
+--ticker table.
+DO $block$
+BEGIN
+IF current_setting('server_version_num')::INT >= 100000 THEN
+
+EXECUTE $$
+CREATE TABLE pglogical_ticker.ticks (
+    provider_name NAME NOT NULL,
+    source_time TIMESTAMPTZ,
+    prev_tick_lsn PG_LSN,
+    set_name NAME NOT NULL
+) PARTITION BY LIST (set_name)
+$$;
+
+END IF;
+END
+$block$;
+
+--Membership of tables in replication sets, from the pglogical catalog
+--table of the installed version, which is only looked up here.  The view
+--is bound to the table, so it follows the rename done by upgrades of
+--pglogical from version 1 to 2.
+DO $block$
+BEGIN
+IF to_regclass('pglogical.replication_set_table') IS NOT NULL THEN
+    EXECUTE $$
+    CREATE VIEW pglogical_ticker.rep_set_table AS
+    SELECT r.set_id, r.set_reloid
+    FROM pglogical.replication_set_table r
+    $$;
+ELSIF to_regclass('pglogical.replication_set_relation') IS NOT NULL THEN
+    EXECUTE $$
+    CREATE VIEW pglogical_ticker.rep_set_table AS
+    SELECT r.set_id, r.set_reloid
+    FROM pglogical.replication_set_relation r
+    $$;
+ELSE
+    RAISE EXCEPTION 'No table pglogical.replication_set_relation or pglogical.replication_set_table found';
+END IF;
+END
+$block$;
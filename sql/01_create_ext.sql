@@ -1,5 +1,5 @@
 -- Allow running regression suite with upgrade paths
-\set v `echo ${FROMVERSION:-1.4}`
+\set v `echo ${FROMVERSION:-1.5}`
 SET client_min_messages = warning;
 CREATE EXTENSION pglogical;
 CREATE EXTENSION pglogical_ticker VERSION :'v';
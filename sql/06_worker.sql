@@ -18,6 +18,67 @@ SELECT pg_sleep(11);
 --Table should now have a greater value for source_time
 SELECT (SELECT source_time FROM pglogical_ticker.test2) > (SELECT source_time FROM checkit) AS time_went_up;
 
+--The second tick carries the commit LSN of the first one
+SELECT prev_tick_lsn IS NOT NULL AS has_prev_tick_lsn FROM pglogical_ticker.test2;
+
+--The worker reports each replication set it ticks in shared memory
+SELECT COUNT(1) > 0 AS has_sets,
+  bool_and(worker_pid = (SELECT pid FROM worker_pid)) AS own_worker,
+  bool_and(last_tick_time IS NOT NULL AND last_commit_lsn IS NOT NULL) AS ticked,
+  bool_and(last_tick_duration_ms >= 0 AND consecutive_errors = 0) AS healthy,
+  bool_and(tick_interval_ms > 0) AS has_interval
+FROM pglogical_ticker.worker_status()
+WHERE database = current_database();
+
+--And its scheduling counters, and the commit LSN of its ticks
+SELECT worker_pid = (SELECT pid FROM worker_pid) AS own_worker,
+  ticks >= 2 AS ticked_twice,
+  late_ticks >= 0 AND missed_ticks >= 0 AS counted
+FROM pglogical_ticker.worker_stats()
+WHERE database = current_database();
+
+SELECT COUNT(1) >= 2 AS logged, bool_and(commit_lsn IS NOT NULL) AS has_commit_lsn
+FROM pglogical_ticker.tick_commits()
+WHERE database = current_database();
+
+--No set is subscribed to here, so there is no lag to sample
+SELECT * FROM pglogical_ticker.lag_histogram() WHERE database = current_database();
+
+--metrics() has every metric, and says the worker is up
+SELECT m AS missing_metric
+FROM unnest(ARRAY['pglogical_ticker_worker_up',
+  'pglogical_ticker_worker_restarts_total',
+  'pglogical_ticker_tick_interval_seconds',
+  'pglogical_ticker_ticks_total',
+  'pglogical_ticker_late_ticks_total',
+  'pglogical_ticker_missed_ticks_total',
+  'pglogical_ticker_tick_errors_total',
+  'pglogical_ticker_tick_duration_seconds',
+  'pglogical_ticker_last_tick_age_seconds',
+  'pglogical_ticker_set_consecutive_errors']) m
+WHERE position('# TYPE ' || m || ' ' IN pglogical_ticker.metrics()) = 0;
+
+SELECT position('pglogical_ticker_worker_up{datname="' || current_database() || '"} 1'
+  IN pglogical_ticker.metrics()) > 0 AS worker_up;
+
+--Every phase of the ticks so far was timed
+SELECT phase, calls >= 2 AS timed,
+  total_ms >= 0 AND avg_ms >= 0 AND recent_avg_ms >= 0
+    AND last_ms >= 0 AND max_ms >= last_ms AS non_negative
+FROM pglogical_ticker.tick_phase_stats()
+WHERE database = current_database()
+ORDER BY phase;
+
+--tick_now() has the worker tick a set right away, and waits for the commit
+CREATE TEMP TABLE ticked_now AS
+SELECT * FROM pglogical_ticker.tick_now('{test1}');
+
+SELECT source_time IS NOT NULL AS has_source_time,
+  commit_time >= source_time AS committed_after,
+  commit_lsn IS NOT NULL AS has_commit_lsn,
+  (SELECT t.source_time FROM pglogical_ticker.test1 t) >= source_time AS written
+FROM ticked_now;
+
 SELECT pg_cancel_backend(pid)
 FROM worker_pid;
 
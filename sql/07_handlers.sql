@@ -14,8 +14,8 @@ CREATE TEMP TABLE bad_pid AS
 SELECT pglogical_ticker._launch(9999999::OID) AS pid;
 
 --Verify that it exits cleanly if the SQL within the worker errors out
---In this case, renaming the function will do it
-ALTER FUNCTION pglogical_ticker.tick() RENAME TO tick_oops;
+--In this case, renaming the function the worker uses to find ticker tables will do it
+ALTER FUNCTION pglogical_ticker.rep_set_table_wrapper() RENAME TO rep_set_table_wrapper_oops;
 DROP TABLE IF EXISTS bad_pid_2;
 CREATE TEMP TABLE bad_pid_2 AS
 SELECT pglogical_ticker.launch() AS pid;
@@ -24,7 +24,7 @@ SELECT pglogical_ticker.launch() AS pid;
 SELECT pg_sleep(2);
 
 -- Fix it
-ALTER FUNCTION pglogical_ticker.tick_oops() RENAME TO tick;
+ALTER FUNCTION pglogical_ticker.rep_set_table_wrapper_oops() RENAME TO rep_set_table_wrapper;
 
 --Verify we can't start multiple workers - the second attempt should return NULL
 --We know this is imperfect but so long as pglogical_ticker.launch is not executed
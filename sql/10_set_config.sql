@@ -0,0 +1,32 @@
+SET client_min_messages TO WARNING;
+
+--Per replication set tick intervals, and sets the worker should not tick
+INSERT INTO pglogical_ticker.set_config (set_name, tick_interval) VALUES ('test1', '200ms');
+INSERT INTO pglogical_ticker.set_config (set_name, enabled) VALUES ('test2', false);
+
+--Intervals under a millisecond are refused
+INSERT INTO pglogical_ticker.set_config (set_name, tick_interval) VALUES ('test3', '0');
+
+SELECT set_name, tick_interval, enabled FROM pglogical_ticker.set_config ORDER BY set_name;
+
+--The configuration is kept by pg_dump
+SELECT extconfig::regclass[] FROM pg_extension WHERE extname = 'pglogical_ticker';
+
+--The worker ticks test1 every 200ms, and does not tick test2
+CREATE TEMP TABLE test2_before AS SELECT source_time FROM pglogical_ticker.test2;
+CREATE TEMP TABLE set_config_worker AS SELECT pglogical_ticker.launch() AS pid;
+SELECT pg_sleep(2);
+
+SELECT set_name, tick_interval_ms
+FROM pglogical_ticker.worker_status()
+WHERE database = current_database() AND set_name IN ('test1', 'test2')
+ORDER BY set_name;
+
+SELECT source_time > now() - interval '1 second' AS ticking_often FROM pglogical_ticker.test1;
+SELECT t.source_time IS NOT DISTINCT FROM b.source_time AS not_ticked
+FROM pglogical_ticker.test2 t, test2_before b;
+
+SELECT pg_cancel_backend(pid) FROM set_config_worker;
+SELECT pg_sleep(1);
+
+DELETE FROM pglogical_ticker.set_config;
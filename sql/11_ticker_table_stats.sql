@@ -0,0 +1,10 @@
+SET client_min_messages TO WARNING;
+
+--Ticker tables are laid out so that ticks are HOT updates
+SELECT reloptions FROM pg_class WHERE oid = 'pglogical_ticker.test1'::REGCLASS;
+
+--Bloat telemetry covers the ticker tables only
+SELECT pglogical_ticker.tick();
+SELECT tablename, pages >= 1 AS has_pages, COALESCE(hot_ratio BETWEEN 0 AND 1, true) AS hot_ratio_valid
+FROM pglogical_ticker.ticker_table_stats()
+WHERE tablename IN ('test1', 'set_config');
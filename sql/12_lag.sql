@@ -0,0 +1,4 @@
+SET client_min_messages TO WARNING;
+
+--Only subscribed replication sets have a lag, and no subscriptions exist here
+SELECT * FROM pglogical_ticker.lag();
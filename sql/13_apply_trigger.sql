@@ -0,0 +1,24 @@
+SET client_min_messages TO WARNING;
+
+--The apply trigger only fires for changes applied by pglogical
+SELECT pglogical_ticker.deploy_ticker_tables(p_apply_trigger := true);
+SELECT tgname, tgenabled FROM pg_trigger WHERE tgrelid = 'pglogical_ticker.test1'::REGCLASS AND NOT tgisinternal;
+
+--Ticking is unaffected, whether or not the trigger fires
+SELECT pglogical_ticker.tick();
+SET session_replication_role = replica;
+UPDATE pglogical_ticker.test1 SET source_time = now();
+RESET session_replication_role;
+SELECT COUNT(1) FROM pglogical_ticker.test1 WHERE source_time IS NOT NULL;
+
+--Changes made in replica mode, as pglogical applies them, are logged by the trigger
+SET session_replication_role = replica;
+INSERT INTO pglogical_ticker.test1 (provider_name, source_time)
+VALUES ('apply_test', now() - interval '1 minute');
+RESET session_replication_role;
+SELECT provider_name, set_name,
+  apply_time > source_time AS applied_after,
+  apply_lag >= interval '1 minute' AS has_lag
+FROM pglogical_ticker.apply_events()
+WHERE database = current_database() AND provider_name = 'apply_test';
+DELETE FROM pglogical_ticker.test1 WHERE provider_name = 'apply_test';
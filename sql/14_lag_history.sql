@@ -0,0 +1,36 @@
+SET client_min_messages TO WARNING;
+
+--Partitions are on UTC boundaries whatever the session time zone
+SET TimeZone = 'America/New_York';
+SELECT pglogical_ticker.lag_history_add_partition('lag_history', 'day', '2020-01-01 12:00+00');
+SELECT pglogical_ticker.lag_history_add_partition('lag_history_1m', 'month', '2020-01-01 12:00+00');
+SELECT pglogical_ticker.lag_history_add_partition('lag_history_1h', 'year', '2020-01-01 12:00+00');
+SET TimeZone = 'UTC';
+
+INSERT INTO pglogical_ticker.lag_history (sample_time, provider_name, set_name, lag)
+SELECT '2020-01-01 12:00+00'::TIMESTAMPTZ + s * INTERVAL '20 seconds', 'test', 'history_test', s * INTERVAL '1 second'
+FROM generate_series(0, 5) s;
+
+--Samples are rolled up by minute, then by hour
+SELECT pglogical_ticker.lag_history_maintenance(INTERVAL '100 years', INTERVAL '100 years');
+SELECT to_char(bucket, 'HH24:MI') AS bucket, set_name, samples,
+    (extract(epoch FROM avg_lag) * 1000)::INT AS avg_lag_ms,
+    (extract(epoch FROM max_lag) * 1000)::INT AS max_lag_ms
+FROM pglogical_ticker.lag_history_1m
+WHERE set_name = 'history_test'
+ORDER BY bucket;
+SELECT to_char(bucket, 'HH24:MI') AS bucket, set_name, samples,
+    (extract(epoch FROM avg_lag) * 1000)::INT AS avg_lag_ms,
+    (extract(epoch FROM max_lag) * 1000)::INT AS max_lag_ms
+FROM pglogical_ticker.lag_history_1h
+WHERE set_name = 'history_test'
+ORDER BY bucket;
+
+--Rolling up again adds nothing
+SELECT pglogical_ticker.lag_history_maintenance(INTERVAL '100 years', INTERVAL '100 years');
+SELECT COUNT(1) FROM pglogical_ticker.lag_history_1m WHERE set_name = 'history_test';
+
+--Expired partitions are dropped, hourly aggregates are kept
+SELECT pglogical_ticker.lag_history_maintenance();
+SELECT relname FROM pg_class WHERE relname LIKE 'lag\_history%\_p2020%' ORDER BY relname;
+RESET TimeZone;
@@ -0,0 +1,24 @@
+SET client_min_messages TO WARNING;
+
+--Attach the ticker tables in replication to pglogical_ticker.ticks
+SELECT pglogical_ticker.migrate_to_ticks() > 0 AS migrated;
+SELECT COUNT(1) > 0 AS has_partitions
+FROM pg_inherits
+WHERE inhparent = 'pglogical_ticker.ticks'::REGCLASS;
+
+--Partitions are still ticked as ticker tables
+DROP TABLE IF EXISTS checkit;
+CREATE TEMP TABLE checkit AS
+SELECT * FROM pglogical_ticker.test1;
+SELECT pglogical_ticker.tick();
+SELECT (SELECT source_time FROM pglogical_ticker.ticks WHERE set_name = 'test1') > (SELECT source_time FROM checkit) AS time_went_up;
+
+--Attaching again does nothing
+SELECT pglogical_ticker.migrate_to_ticks();
+
+--Detach them again
+SELECT pglogical_ticker.migrate_from_ticks() > 0 AS migrated;
+SELECT COUNT(1)
+FROM pg_inherits
+WHERE inhparent = 'pglogical_ticker.ticks'::REGCLASS;
+SELECT pglogical_ticker.tick();
@@ -0,0 +1,19 @@
+SET client_min_messages TO WARNING;
+
+--Deploy again with the DDL of several tables per replicated command
+CREATE TEMP TABLE queued AS SELECT COUNT(1) AS n FROM pglogical.queue;
+SELECT pglogical_ticker.deploy_ticker_tables(p_batch_size := 4) = (SELECT COUNT(1) FROM pglogical.replication_set) AS deployed_all;
+
+--Each batch of 4 tables is a single queued DDL message
+SELECT (SELECT COUNT(1) FROM pglogical.queue) - q.n = (SELECT (COUNT(1) + 3) / 4 FROM pglogical.replication_set) AS one_command_per_batch
+FROM queued q;
+
+--Every ticker table is already in replication
+SELECT * FROM pglogical_ticker.ticker_tables_to_add();
+SELECT pglogical_ticker.add_ticker_tables_to_replication();
+
+--Provisioning of new replication sets, as the worker does with pglogical_ticker.auto_provision
+SELECT pglogical.create_replication_set('auto1') IS NOT NULL AS created;
+SELECT pglogical_ticker.provision_ticker_tables('{auto1,test1}');
+SELECT pglogical_ticker.provision_ticker_tables('{auto1,test1}');
+SELECT * FROM pglogical_ticker.ticker_tables_to_add();
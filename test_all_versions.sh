@@ -3,7 +3,7 @@
 set -eu
 
 orig_path=$PATH
-newest_version=1.4
+newest_version=1.5
 
 unset PGSERVICE
 
@@ -73,6 +73,24 @@ EOM
 echo "PASS"
 }
 
+assert_ticker_attached() {
+PGPORT=$port psql contrib_regression -v "ON_ERROR_STOP" << 'EOM'
+DO $$
+BEGIN
+
+IF NOT EXISTS (SELECT 1
+    FROM pglogical_ticker.worker_stats() w
+    INNER JOIN pg_stat_activity a ON a.pid = w.worker_pid
+    WHERE w.database = current_database()
+      AND a.datname = current_database()) THEN
+    RAISE EXCEPTION 'No ticker attached to this database';
+END IF;
+
+END$$;
+EOM
+echo "PASS"
+}
+
 ticker_check() {
 echo "Launching ticker if not launched"
 PGPORT=$port psql contrib_regression -v "ON_ERROR_STOP" << 'EOM' > /dev/null
@@ -108,6 +126,15 @@ sudo kill -9 $pid
 sleep 12
 ticker_check
 
+# pglogical_ticker.database names another database, which supervised workers must ignore
+echo "Testing autodiscover with pglogical_ticker.database still set"
+sudo -u postgres sed -i "s/pglogical_ticker.database = 'contrib_regression'/pglogical_ticker.database = 'postgres'/" /etc/postgresql/$version/main/postgresql.conf
+sudo -u postgres sed -i "\$apglogical_ticker.autodiscover = on" /etc/postgresql/$version/main/postgresql.conf
+sigpg restart
+sleep 11
+assert_ticker_attached
+sudo -u postgres sed -i "/pglogical_ticker.autodiscover/d" /etc/postgresql/$version/main/postgresql.conf
+
 sudo -u postgres sed -i "/pglogical_ticker.database/d" /etc/postgresql/$version/main/postgresql.conf
 sigpg restart
 sleep 11
@@ -127,5 +154,6 @@ make_and_test "10"
 make_and_test "11"
 }
 
+test_all_versions "1.5"
 test_all_versions "1.4"
 test_all_versions "1.3"